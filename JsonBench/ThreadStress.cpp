@@ -0,0 +1,119 @@
+// ThreadStress.cpp : Parses, queries and serializes the same documents on a growing number of
+// threads and reports the throughput of each run. Every thread also parses invalid input and
+// checks that it only ever sees its own errors.
+//
+// usage: ThreadStress [max threads] [iterations per thread]
+//
+
+#include "../PureJson/PureJson.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string makeDocument(int records)
+{
+	std::string doc = "{\"version\": 3, \"records\": [";
+
+	for (int i = 0; i < records; i++)
+	{
+		if (i) doc += ",";
+		doc += "{\"id\": " + std::to_string(i) + ", \"name\": \"record " + std::to_string(i) +
+			"\", \"score\": " + std::to_string(i * 0.25) + ", \"active\": " + (i % 2 ? "true" : "false") +
+			", \"tags\": [\"a\", \"b\\n\", \"c\"], \"owner\": {\"id\": " + std::to_string(i % 97) + ", \"name\": \"x\"}}";
+	}
+
+	doc += "]}";
+	return doc;
+}
+
+// returns false if anything came out wrong
+static bool runIteration(const std::string& doc, int records, int iteration)
+{
+	pj_Object* json = pj_parseObj(doc.c_str());
+	if (!json || pj_popError()) return false;
+
+	pj_Array* array = pj_objGetArray(json, "records");
+	const int index = iteration % records;
+
+	bool ok = pj_getArraySize(array) == (size_t)records &&
+		pj_objGetInt64(pj_arrayGetObj(array, index), "id") == index &&
+		pj_objGetNum(pj_arrayGetObj(array, index), "owner.id") == index % 97;
+
+	size_t length = 0;
+	char* str = pj_objToStringLen(json, false, &length);
+	ok = ok && length > doc.size() / 2;
+
+	pj_deleteString(str);
+	pj_deleteObj(json);
+
+	// the errors raised on this thread have to be exactly the ones it sees, most recent first
+	pj_Object* invalid = pj_parseObj("{\"unterminated\": [1, 2 }");
+	pj_deleteObj(invalid);
+
+	const char* error = pj_popError();
+	ok = ok && error && strstr(error, "Missing comma after property value");
+
+	error = pj_popError();
+	ok = ok && error && strstr(error, "Missing comma after array element");
+
+	ok = ok && !pj_popError();
+
+	return ok;
+}
+
+int main(int argc, char** argv)
+{
+	const int maxThreads = argc > 1 ? atoi(argv[1]) : (int)std::max(1u, std::thread::hardware_concurrency());
+	const int iterations = argc > 2 ? atoi(argv[2]) : 20;
+	const int records = 2000;
+
+	const std::string doc = makeDocument(records);
+	std::cout << "document: " << doc.size() << " bytes, " << iterations << " iterations per thread" << std::endl;
+
+	double baseline = 0;
+	bool allOk = true;
+
+	// powers of two up to the maximum, then the maximum itself
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+	threadCounts.push_back(std::max(1, maxThreads));
+
+	for (int threads : threadCounts)
+	{
+		std::atomic<int> failures{ 0 };
+		std::vector<std::thread> workers;
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int t = 0; t < threads; t++)
+		{
+			workers.emplace_back([&]()
+			{
+				for (int i = 0; i < iterations; i++)
+				{
+					if (!runIteration(doc, records, i)) failures++;
+				}
+			});
+		}
+
+		for (std::thread& worker : workers) worker.join();
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const double docsPerSecond = threads * iterations / seconds;
+		if (threads == 1) baseline = docsPerSecond;
+
+		std::cout << threads << " threads: " << docsPerSecond << " docs/s, " <<
+			(doc.size() * docsPerSecond / 1e6) << " MB/s, speedup " << docsPerSecond / baseline <<
+			", failures " << failures << std::endl;
+
+		allOk = allOk && failures == 0;
+	}
+
+	return allOk ? 0 : 1;
+}
@@ -0,0 +1,563 @@
+// Throughput.cpp : Measures parse and serialize throughput, lookup latency and memory per
+// document on generated corpora (numeric heavy, string heavy, deeply nested and wide objects)
+// and on any JSON files given, such as the usual canada.json, citm_catalog.json and twitter.json.
+// Results are printed as a table and, with --json, written as JSON so runs can be compared
+// across versions. --dump writes out the generated corpora so other parsers can be run on them.
+//
+// usage: Throughput [--time seconds] [--scale n] [--quick] [--json results.json] [--dump dir] [files...]
+//
+// Returns 1 if a document does not survive a round trip or a lookup comes up empty.
+//
+
+#include "../PureJson/PureJson.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Every allocation is counted, so the memory a document holds is what the heap grew by while
+// it was parsed. The size and the block malloc returned sit right before what is handed out
+static std::atomic<size_t> liveBytes{ 0 };
+
+static void* countedAlloc(size_t size, size_t alignment)
+{
+	const size_t header = alignment < 2 * sizeof(void*) ? 2 * sizeof(void*) : alignment;
+
+	char* block = (char*)malloc(size + header + alignment);
+	if (!block) throw std::bad_alloc();
+
+	char* mem = (char*)(((uintptr_t)block + header + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	((void**)mem)[-1] = block;
+	((size_t*)mem)[-2] = size;
+
+	liveBytes.fetch_add(size, std::memory_order_relaxed);
+	return mem;
+}
+
+static void countedFree(void* mem)
+{
+	if (!mem) return;
+
+	liveBytes.fetch_sub(((size_t*)mem)[-2], std::memory_order_relaxed);
+	free(((void**)mem)[-1]);
+}
+
+void* operator new(size_t size) { return countedAlloc(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return countedAlloc(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t alignment) { return countedAlloc(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return countedAlloc(size, (size_t)alignment); }
+void operator delete(void* mem) noexcept { countedFree(mem); }
+void operator delete[](void* mem) noexcept { countedFree(mem); }
+void operator delete(void* mem, size_t) noexcept { countedFree(mem); }
+void operator delete[](void* mem, size_t) noexcept { countedFree(mem); }
+void operator delete(void* mem, std::align_val_t) noexcept { countedFree(mem); }
+void operator delete[](void* mem, std::align_val_t) noexcept { countedFree(mem); }
+void operator delete(void* mem, size_t, std::align_val_t) noexcept { countedFree(mem); }
+void operator delete[](void* mem, size_t, std::align_val_t) noexcept { countedFree(mem); }
+
+// a dotted path into the root object, to a string or a number other than 0
+struct Lookup
+{
+	std::string name;
+	std::string path;
+	bool isString;
+};
+
+struct Corpus
+{
+	std::string name;
+	std::string text;
+	std::vector<Lookup> lookups;
+};
+
+struct Result
+{
+	std::string corpus;
+	std::string benchmark;
+	std::string metric;
+	double value;
+	std::string unit;
+};
+
+struct ParseMode
+{
+	const char* name;
+	unsigned int flags;
+	pj_ParseEngine engine;
+};
+
+static const ParseMode parseModes[] =
+{
+	{ "parse", PJ_PARSE_DEFAULT, PJ_ENGINE_RECURSIVE },
+	{ "parse arena", PJ_PARSE_ARENA, PJ_ENGINE_RECURSIVE },
+	{ "parse intern keys", PJ_PARSE_INTERN_KEYS, PJ_ENGINE_RECURSIVE },
+	{ "parse structural index", PJ_PARSE_ARENA, PJ_ENGINE_STRUCTURAL_INDEX },
+	{ "parse lazy", PJ_PARSE_LAZY, PJ_ENGINE_RECURSIVE },
+};
+
+// a parsed document, only the pointer matching its root is set
+struct Document
+{
+	pj_Object* obj = nullptr;
+	pj_Array* array = nullptr;
+};
+
+static bool isArrayText(const std::string& text)
+{
+	const size_t first = text.find_first_not_of(" \t\r\n");
+	return first != std::string::npos && text[first] == '[';
+}
+
+static Document parseDocument(const std::string& text, unsigned int flags)
+{
+	Document doc;
+	if (isArrayText(text))
+		doc.array = pj_parseArrayEx(text.c_str(), flags);
+	else
+		doc.obj = pj_parseObjEx(text.c_str(), flags);
+
+	return doc;
+}
+
+static void deleteDocument(Document& doc)
+{
+	pj_deleteObj(doc.obj);
+	pj_deleteArray(doc.array);
+	doc = Document();
+}
+
+static std::string documentToString(const Document& doc, bool isPretty)
+{
+	size_t length = 0;
+	char* str = doc.obj ? pj_objToStringLen(doc.obj, isPretty, &length) : pj_arrayToStringLen(doc.array, isPretty, &length);
+
+	std::string result(str, length);
+	pj_deleteString(str);
+	return result;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string makeNumeric(std::mt19937& rng, int scale)
+{
+	std::uniform_real_distribution<double> real(-1000.0, 1000.0);
+	std::uniform_int_distribution<int> exponent(-12, 12);
+	const int rows = 20000 * scale;
+
+	std::string doc = "{\"meta\": {\"rows\": " + std::to_string(rows) + ", \"scale\": 0.5}, \"rows\": [";
+	char number[32];
+
+	for (int i = 0; i < rows; i++)
+	{
+		if (i) doc += ",";
+		doc += "[";
+		for (int j = 0; j < 3; j++)
+		{
+			snprintf(number, sizeof(number), "%.17g", real(rng) * pow(10.0, exponent(rng)));
+			doc += number;
+			doc += ", ";
+		}
+		doc += std::to_string(rng()) + "]";
+	}
+
+	doc += "]}";
+	return doc;
+}
+
+static std::string makeStrings(std::mt19937& rng, int scale)
+{
+	static const char* const words[] =
+	{
+		"lorem", "ipsum", "dolor", "sit", "amet", "caf\\u00e9", "na\xC3\xAFve", "\\\"quoted\\\"",
+		"tab\\there", "line\\nbreak", "back\\\\slash", "\xE6\x97\xA5\xE6\x9C\xAC", "emoji \\ud83d\\ude00"
+	};
+	const int posts = 10000 * scale;
+
+	std::string doc = "{\"meta\": {\"title\": \"string heavy\", \"author\": \"Pure Json\"}, \"posts\": [";
+
+	for (int i = 0; i < posts; i++)
+	{
+		if (i) doc += ",";
+		doc += "{\"user\": \"user" + std::to_string(rng() % 5000) + "\", \"lang\": \"en\", \"text\": \"";
+		for (int w = 10 + rng() % 40; w > 0; w--)
+		{
+			doc += words[rng() % (sizeof(words) / sizeof(words[0]))];
+			doc += " ";
+		}
+		doc += "\"}";
+	}
+
+	doc += "]}";
+	return doc;
+}
+
+static std::string makeChain(int depth, int leaf)
+{
+	std::string chain;
+	for (int i = 0; i < depth; i++)
+		chain += "{\"level\": " + std::to_string(i) + ", \"child\": ";
+
+	chain += "{\"leaf\": " + std::to_string(leaf) + "}";
+	chain.append(depth, '}');
+	return chain;
+}
+
+static std::string makeNested(std::mt19937& rng, int scale)
+{
+	const int depth = 64;
+	const int trees = 2000 * scale;
+
+	std::string doc = "{\"tree\": " + makeChain(depth, 1) + ", \"trees\": [";
+
+	for (int i = 0; i < trees; i++)
+	{
+		if (i) doc += ",";
+		doc += i % 2 ? makeChain(1 + rng() % depth, i) : "[[[[[[[[" + std::to_string(i) + "]]]]]]]]";
+	}
+
+	doc += "]}";
+	return doc;
+}
+
+static std::string makeWide(std::mt19937& rng, int scale)
+{
+	const int fields = 50000 * scale;
+	const int records = 1000 * scale;
+
+	std::string doc = "{\"fields\": {";
+	for (int i = 0; i < fields; i++)
+	{
+		if (i) doc += ",";
+		doc += "\"field" + std::to_string(i) + "\": " + std::to_string(1 + rng() % 100000);
+	}
+
+	doc += "}, \"records\": [";
+	for (int i = 0; i < records; i++)
+	{
+		if (i) doc += ",";
+		doc += "{";
+		for (int k = 0; k < 64; k++)
+		{
+			if (k) doc += ", ";
+			doc += "\"column" + std::to_string(k) + "\": " + (k % 4 ? std::to_string(rng() % 1000) : "\"text\"");
+		}
+		doc += "}";
+	}
+
+	doc += "]}";
+	return doc;
+}
+
+static std::vector<Corpus> makeCorpora(int scale)
+{
+	std::mt19937 rng(2024);
+	std::vector<Corpus> corpora;
+
+	corpora.push_back({ "numeric", makeNumeric(rng, scale), { { "meta.rows", "meta.rows", false }, { "meta.scale", "meta.scale", false } } });
+	corpora.push_back({ "strings", makeStrings(rng, scale), { { "meta.title", "meta.title", true }, { "meta.author", "meta.author", true } } });
+
+	std::string deepPath = "tree";
+	for (int i = 0; i < 32; i++) deepPath += ".child";
+	corpora.push_back({ "nested", makeNested(rng, scale), { { "depth 2", "tree.child.level", false }, { "depth 34", deepPath + ".level", false } } });
+
+	const int fields = 50000 * scale;
+	corpora.push_back({ "wide", makeWide(rng, scale), {
+		{ "first field", "fields.field0", false },
+		{ "middle field", "fields.field" + std::to_string(fields / 2), false },
+		{ "last field", "fields.field" + std::to_string(fields - 1), false } } });
+
+	return corpora;
+}
+
+static bool readFile(const char* fileName, std::string& text)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (!file) return false;
+
+	char buffer[64 * 1024];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		text.append(buffer, read);
+
+	fclose(file);
+	return true;
+}
+
+static bool writeFile(const std::string& fileName, const std::string& text)
+{
+	FILE* file = fopen(fileName.c_str(), "wb");
+	if (!file) return false;
+
+	const bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+	return (fclose(file) == 0) && written;
+}
+
+static void benchParse(const Corpus& corpus, double minSeconds, std::vector<Result>& results)
+{
+	for (const ParseMode& mode : parseModes)
+	{
+		pj_setParseEngine(mode.engine);
+
+		double seconds = 0;
+		size_t iterations = 0;
+		size_t memory = 0;
+
+		do
+		{
+			const size_t before = liveBytes.load(std::memory_order_relaxed);
+			const auto start = std::chrono::steady_clock::now();
+
+			Document doc = parseDocument(corpus.text, mode.flags);
+
+			seconds += secondsSince(start);
+			memory = liveBytes.load(std::memory_order_relaxed) - before;
+			iterations++;
+
+			deleteDocument(doc);
+		} while (seconds < minSeconds);
+
+		results.push_back({ corpus.name, mode.name, "throughput", corpus.text.size() * iterations / seconds / 1e6, "MB/s" });
+		results.push_back({ corpus.name, mode.name, "memory", (double)memory, "bytes" });
+		results.push_back({ corpus.name, mode.name, "memory per input byte", (double)memory / corpus.text.size(), "bytes" });
+	}
+
+	pj_setParseEngine(PJ_ENGINE_RECURSIVE);
+}
+
+static void benchSerialize(const Corpus& corpus, const Document& doc, double minSeconds, std::vector<Result>& results)
+{
+	struct Variant { const char* name; bool isPretty; bool isParallel; };
+	static const Variant variants[] =
+	{
+		{ "serialize", false, false },
+		{ "serialize pretty", true, false },
+		{ "serialize parallel", false, true },
+	};
+
+	for (const Variant& variant : variants)
+	{
+		double seconds = 0;
+		size_t iterations = 0;
+		size_t bytes = 0;
+
+		do
+		{
+			size_t length = 0;
+			const auto start = std::chrono::steady_clock::now();
+
+			char* str;
+			if (variant.isParallel)
+				str = doc.obj ? pj_objToStringParallel(doc.obj, variant.isPretty, 0, &length) : pj_arrayToStringParallel(doc.array, variant.isPretty, 0, &length);
+			else
+				str = doc.obj ? pj_objToStringLen(doc.obj, variant.isPretty, &length) : pj_arrayToStringLen(doc.array, variant.isPretty, &length);
+
+			seconds += secondsSince(start);
+			bytes += length;
+			iterations++;
+
+			pj_deleteString(str);
+		} while (seconds < minSeconds);
+
+		results.push_back({ corpus.name, variant.name, "throughput", bytes / seconds / 1e6, "MB/s" });
+	}
+}
+
+// returns false if a lookup finds nothing
+static bool benchLookups(const Corpus& corpus, pj_Object* obj, double minSeconds, std::vector<Result>& results)
+{
+	const int batch = 1000;
+	bool ok = true;
+
+	for (const Lookup& lookup : corpus.lookups)
+	{
+		pj_Path* path = pj_compilePath(lookup.path.c_str());
+
+		if (lookup.isString)
+			ok = ok && pj_objGetString(obj, lookup.path.c_str()) && pj_objGetStringAt(obj, path);
+		else
+			ok = ok && pj_objGetNum(obj, lookup.path.c_str()) != 0 && pj_objGetNumAt(obj, path) == pj_objGetNum(obj, lookup.path.c_str());
+
+		for (int compiled = 0; compiled < 2; compiled++)
+		{
+			double seconds = 0;
+			size_t iterations = 0;
+			volatile double sink = 0;
+
+			do
+			{
+				const auto start = std::chrono::steady_clock::now();
+
+				for (int i = 0; i < batch; i++)
+				{
+					if (lookup.isString)
+						sink = sink + (double)(compiled ? pj_objGetStringAt(obj, path) : pj_objGetString(obj, lookup.path.c_str()))[0];
+					else
+						sink = sink + (compiled ? pj_objGetNumAt(obj, path) : pj_objGetNum(obj, lookup.path.c_str()));
+				}
+
+				seconds += secondsSince(start);
+				iterations += batch;
+			} while (seconds < minSeconds);
+
+			const std::string name = compiled ? "lookup compiled " + lookup.name : "lookup " + lookup.name;
+			results.push_back({ corpus.name, name, "latency", seconds / iterations * 1e9, "ns" });
+		}
+
+		pj_deletePath(path);
+	}
+
+	return ok;
+}
+
+// returns false if the corpus does not parse back into itself
+static bool benchCorpus(const Corpus& corpus, double minSeconds, std::vector<Result>& results)
+{
+	Document doc = parseDocument(corpus.text, PJ_PARSE_DEFAULT);
+	if ((!doc.obj && !doc.array) || pj_popError())
+	{
+		std::cerr << corpus.name << ": does not parse" << std::endl;
+		deleteDocument(doc);
+		return false;
+	}
+
+	const std::string compact = documentToString(doc, false);
+	Document again = parseDocument(compact, PJ_PARSE_DEFAULT);
+	bool ok = (again.obj || again.array) && documentToString(again, false) == compact;
+	deleteDocument(again);
+
+	if (!ok) std::cerr << corpus.name << ": round trip differs" << std::endl;
+
+	results.push_back({ corpus.name, "input", "size", (double)corpus.text.size(), "bytes" });
+
+	benchParse(corpus, minSeconds, results);
+	benchSerialize(corpus, doc, minSeconds, results);
+
+	if (doc.obj && !benchLookups(corpus, doc.obj, minSeconds, results))
+	{
+		std::cerr << corpus.name << ": lookup came up empty" << std::endl;
+		ok = false;
+	}
+
+	deleteDocument(doc);
+	return ok;
+}
+
+static bool writeResults(const std::vector<Result>& results, const char* fileName)
+{
+	FILE* file = fopen(fileName, "w");
+	if (!file) return false;
+
+	pj_Builder* builder = pj_createStreamBuilder(true, file);
+	pj_builderBeginObject(builder);
+	pj_builderKey(builder, "library");
+	pj_builderString(builder, "PureJson");
+	pj_builderKey(builder, "results");
+	pj_builderBeginArray(builder);
+
+	for (const Result& result : results)
+	{
+		pj_builderBeginObject(builder);
+		pj_builderKey(builder, "corpus");
+		pj_builderString(builder, result.corpus.c_str());
+		pj_builderKey(builder, "benchmark");
+		pj_builderString(builder, result.benchmark.c_str());
+		pj_builderKey(builder, "metric");
+		pj_builderString(builder, result.metric.c_str());
+		pj_builderKey(builder, "value");
+		pj_builderNum(builder, result.value);
+		pj_builderKey(builder, "unit");
+		pj_builderString(builder, result.unit.c_str());
+		pj_builderEndObject(builder);
+	}
+
+	pj_builderEndArray(builder);
+	pj_builderEndObject(builder);
+
+	const bool written = pj_finishBuilder(builder);
+	return (fclose(file) == 0) && written;
+}
+
+int main(int argc, char** argv)
+{
+	double minSeconds = 0.5;
+	int scale = 1;
+	const char* jsonFile = nullptr;
+	const char* dumpDir = nullptr;
+	std::vector<const char*> files;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--time") && i + 1 < argc) minSeconds = atof(argv[++i]);
+		else if (!strcmp(argv[i], "--scale") && i + 1 < argc) scale = std::max(1, atoi(argv[++i]));
+		else if (!strcmp(argv[i], "--quick")) minSeconds = 0.01;
+		else if (!strcmp(argv[i], "--json") && i + 1 < argc) jsonFile = argv[++i];
+		else if (!strcmp(argv[i], "--dump") && i + 1 < argc) dumpDir = argv[++i];
+		else files.push_back(argv[i]);
+	}
+
+	std::vector<Corpus> corpora = makeCorpora(scale);
+
+	for (const char* fileName : files)
+	{
+		Corpus corpus;
+		corpus.name = fileName;
+		corpus.name.erase(0, corpus.name.find_last_of("/\\") + 1);
+		if (!readFile(fileName, corpus.text))
+		{
+			std::cerr << "cannot read " << fileName << std::endl;
+			return 1;
+		}
+
+		corpora.push_back(std::move(corpus));
+	}
+
+	if (dumpDir)
+	{
+		for (size_t i = 0; i < corpora.size() - files.size(); i++)
+		{
+			const std::string fileName = std::string(dumpDir) + "/" + corpora[i].name + ".json";
+			if (!writeFile(fileName, corpora[i].text))
+			{
+				std::cerr << "cannot write " << fileName << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	std::vector<Result> results;
+	bool allOk = true;
+
+	for (const Corpus& corpus : corpora)
+	{
+		const size_t first = results.size();
+		allOk = benchCorpus(corpus, minSeconds, results) && allOk;
+
+		for (size_t i = first; i < results.size(); i++)
+		{
+			const Result& result = results[i];
+			std::cout << std::left << std::setw(12) << result.corpus << " " << std::setw(40) << result.benchmark << " " <<
+				std::setw(24) << result.metric << std::right << std::setw(14) << std::fixed << std::setprecision(2) <<
+				result.value << " " << result.unit << std::endl;
+		}
+	}
+
+	if (jsonFile && !writeResults(results, jsonFile))
+	{
+		std::cerr << "cannot write " << jsonFile << std::endl;
+		return 1;
+	}
+
+	return allOk ? 0 : 1;
+}
@@ -11,18 +11,7 @@
 
 int main()
 {
-	FILE *f = fopen("test.json", "rb");
-	fseek(f, 0, SEEK_END);
-	long fsize = ftell(f);
-	fseek(f, 0, SEEK_SET);  
-
-	char *rawJson = (char*)malloc(fsize + 1);
-	fread(rawJson, fsize, 1, f);
-	fclose(f);
-
-	rawJson[fsize] = 0;
-
-	pj::ObjectRoot json = pj_parseObj(rawJson);
+	pj::ObjectRoot json = pj_parseObjFile("test.json");
 
 	bool p1 = pj_objGetBool(json.handle, "prop");
 	double p2 = pj_objGetNum(json.handle, "prop2");
@@ -50,6 +39,9 @@ int main()
 			case PJ_VALUE_NUMBER:
 				std::cout << pj_objGetNum(obj, key) << std::endl;
 			break;
+			case PJ_VALUE_INT64:
+				std::cout << pj_objGetInt64(obj, key) << std::endl;
+			break;
 			case PJ_VALUE_STRING:
 				std::cout << pj_objGetString(obj, key) << std::endl;
 			break;
@@ -81,8 +73,6 @@ int main()
 
 	pj_objToFile(json.handle, true, "testout.json");
 
-	free(rawJson);
-
     return 0;
 }
 
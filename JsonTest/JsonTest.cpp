@@ -0,0 +1,1207 @@
+// JsonTest.cpp : Behavioural tests of the parsers, serializers and lookups. Every check that
+// fails is printed with its line, the exit code is 1 if any did.
+//
+
+#include "../PureJson/PureJson.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if (!(condition)) { failures++; std::cerr << __FILE__ << ":" << __LINE__ << ": " << #condition << std::endl; } } while (0)
+
+static std::string take(char* str, size_t length)
+{
+	std::string result(str, length);
+	pj_deleteString(str);
+	return result;
+}
+
+static std::string arrayString(pj_Array* array, bool isPretty = false)
+{
+	if (!array) return "<null>";
+
+	size_t length = 0;
+	char* str = pj_arrayToStringLen(array, isPretty, &length);
+	return take(str, length);
+}
+
+static std::string objString(pj_Object* obj, bool isPretty = false)
+{
+	if (!obj) return "<null>";
+
+	size_t length = 0;
+	char* str = pj_objToStringLen(obj, isPretty, &length);
+	return take(str, length);
+}
+
+static void clearErrors()
+{
+	while (pj_popError()) {}
+}
+
+static void testArrays()
+{
+	// parsed arrays are sized from a count of their elements
+	pj_Array* array = pj_parseArray("[\"a,b]\", {}, [[], \"]\"], 3 ]");
+	CHECK(pj_getArraySize(array) == 4);
+	CHECK(pj_getArrayCapacity(array) == 4);
+	CHECK(pj_getArrayCapacity(pj_arrayGetArray(array, 2)) == 2);
+	CHECK(pj_getArrayCapacity(pj_arrayGetArray(pj_arrayGetArray(array, 2), 0)) == 0);
+	pj_deleteArray(array);
+
+	array = pj_parseArray("[ ]");
+	CHECK(pj_getArraySize(array) == 0);
+	CHECK(pj_getArrayCapacity(array) == 0);
+	pj_deleteArray(array);
+
+	array = pj_createArray();
+	pj_arrayReserve(array, 100);
+	CHECK(pj_getArrayCapacity(array) >= 100);
+	CHECK(pj_getArraySize(array) == 0);
+
+	for (int i = 0; i < 1000; i++) pj_arrayAddNum(array, i);
+	CHECK(pj_getArraySize(array) == 1000);
+	CHECK(pj_getArrayCapacity(array) >= 1000);
+
+	pj_arrayShrinkToFit(array);
+	CHECK(pj_getArrayCapacity(array) == 1000);
+	CHECK(pj_arrayGetNum(array, 999) == 999);
+
+	// reserving less than the size keeps every element
+	pj_arrayReserve(array, 10);
+	CHECK(pj_getArraySize(array) == 1000);
+	CHECK(pj_arrayGetNum(array, 0) == 0);
+	pj_deleteArray(array);
+
+	CHECK(pj_popError() == nullptr);
+}
+
+static void testArena()
+{
+	const char* text = "{\"a\": [1, \"two\", {\"b\": null}], \"c\": {\"d\": true, \"e\": \"f\"}}";
+
+	pj_Object* heap = pj_parseObj(text);
+	pj_Object* arena = pj_parseObjEx(text, PJ_PARSE_ARENA);
+	CHECK(objString(arena) == objString(heap));
+	CHECK(objString(arena, true) == objString(heap, true));
+
+	// nodes from the heap are freed along with the arena document they are added to
+	pj_Array* added = pj_createArray();
+	pj_arrayAddString(added, "added");
+	pj_objSetArray(arena, "g", added);
+	pj_arrayAddObj(pj_objGetArray(arena, "a"), pj_createObj());
+	pj_objSetString(pj_objGetObj(arena, "c"), "e", "replaced");
+
+	pj_objSetArray(heap, "g", pj_parseArray("[\"added\"]"));
+	pj_arrayAddObj(pj_objGetArray(heap, "a"), pj_createObj());
+	pj_objSetString(pj_objGetObj(heap, "c"), "e", "replaced");
+	CHECK(objString(arena) == objString(heap));
+
+	// deleting anything but the root of an arena document does nothing
+	pj_deleteObj(pj_objGetObj(arena, "c"));
+	CHECK(pj_objGetBool(pj_objGetObj(arena, "c"), "d"));
+
+	pj_deleteObj(arena);
+	pj_deleteObj(heap);
+
+	pj_Array* array = pj_parseArrayEx("[[1, 2], {\"x\": \"y\"}, \"z\"]", PJ_PARSE_ARENA);
+	pj_Array* heapArray = pj_parseArray("[[1, 2], {\"x\": \"y\"}, \"z\"]");
+	CHECK(arrayString(array) == arrayString(heapArray));
+	CHECK(pj_getArraySize(array) == 3);
+	CHECK(pj_arrayGetNum(pj_arrayGetArray(array, 0), 1) == 2);
+	CHECK(strcmp(pj_objGetString(pj_arrayGetObj(array, 1), "x"), "y") == 0);
+	CHECK(strcmp(pj_arrayGetString(array, 2), "z") == 0);
+	pj_deleteArray(heapArray);
+	pj_deleteArray(array);
+
+	CHECK(pj_popError() == nullptr);
+}
+
+static void testInSitu()
+{
+	const std::string text = "{\"plain\": \"abc\", \"esc\\taped\": \"q\\\"b\\\\s\\/\\n\\u00e9\\ud83d\\ude00\", \"list\": [\"x\", {\"y\": \"z\"}]}";
+
+	std::string buffer = text;
+	pj_Object* inSitu = pj_parseObjInSitu(&buffer[0]);
+	pj_Object* copied = pj_parseObj(text.c_str());
+
+	// strings are decoded where they are, inside the buffer
+	const char* plain = pj_objGetString(inSitu, "plain");
+	CHECK(plain >= buffer.data() && plain < buffer.data() + buffer.size());
+	CHECK(strcmp(plain, "abc") == 0);
+	CHECK(strcmp(pj_objGetString(inSitu, "esc\taped"), "q\"b\\s/\n\xC3\xA9\xF0\x9F\x98\x80") == 0);
+	CHECK(strcmp(pj_objGetString(pj_arrayGetObj(pj_objGetArray(inSitu, "list"), 1), "y"), "z") == 0);
+
+	// escaping on the way out gives back an equivalent document
+	CHECK(objString(inSitu) == objString(copied));
+	pj_Object* again = pj_parseObj(objString(inSitu).c_str());
+	CHECK(strcmp(pj_objGetString(again, "esc\taped"), pj_objGetString(copied, "esc\taped")) == 0);
+
+	pj_deleteObj(again);
+	pj_deleteObj(copied);
+	pj_deleteObj(inSitu);
+
+	buffer = "[\"a\\u0041\", [\"\"]]";
+	pj_Array* array = pj_parseArrayInSitu(&buffer[0]);
+	CHECK(strcmp(pj_arrayGetString(array, 0), "aA") == 0);
+	CHECK(strcmp(pj_arrayGetString(pj_arrayGetArray(array, 1), 0), "") == 0);
+	pj_deleteArray(array);
+
+	CHECK(pj_popError() == nullptr);
+}
+
+static void testScanning()
+{
+	// whitespace runs and escapes at every offset around the 16 and 32 byte blocks
+	for (size_t n = 0; n < 80; n++)
+	{
+		const std::string padding(n, n % 3 ? ' ' : '\n');
+		const std::string body(n, 'x');
+		const std::string text = "[" + padding + "\"" + body + "\\\"" + body + "\\\\\"" + padding + "," + padding + "{\"" + body + "\": []}" + padding + "]";
+
+		pj_Array* array = pj_parseArray(text.c_str());
+		CHECK(pj_getArraySize(array) == 2);
+		CHECK(pj_getArraySize(array) == 2 && pj_arrayGetString(array, 0) == body + "\"" + body + "\\");
+		CHECK(pj_getArraySize(array) == 2 && pj_isObjPropOfType(pj_arrayGetObj(array, 1), body.c_str(), PJ_VALUE_ARRAY));
+		pj_deleteArray(array);
+	}
+
+	CHECK(pj_popError() == nullptr);
+}
+
+static const char* const validDocuments[] =
+{
+	"{}",
+	"[]",
+	"{\"a\": 1, \"b\": [true, false, null], \"c\": {\"d\": \"e\"}}",
+	"  [1, -2, 3.5, -0, 1e10, 2.5E-3, 12345678901234567890, \"\\u00e9\\n\\\"\\\\\", [], {}]  ",
+	"{\"nested\": [[[[{\"deep\": [[[]]]}]]]], \"empty\": \"\", \"unicode\": \"\\ud83d\\ude00 \xE6\x97\xA5\"}",
+	"[{\"id\": 1, \"tags\": [\"x\", \"y\"]}, {\"id\": 2, \"tags\": []}, {\"id\": 3}]",
+	"{\"k0\": 0, \"k1\": 1, \"k2\": 2, \"k3\": 3, \"k4\": 4, \"k5\": 5, \"k6\": 6, \"k7\": 7, \"k8\": 8, "
+		"\"k9\": 9, \"k10\": 10, \"k11\": 11, \"k12\": 12, \"k13\": 13, \"k14\": 14, \"k15\": 15, \"k16\": 16, \"k17\": 17}",
+};
+
+static std::string parseWith(const char* text, pj_ParseEngine engine, unsigned int flags, bool isPretty)
+{
+	pj_setParseEngine(engine);
+
+	const bool isArray = text[strspn(text, " \t\r\n")] == '[';
+	std::string result;
+
+	if (isArray)
+	{
+		pj_Array* array = pj_parseArrayEx(text, flags);
+		result = arrayString(array, isPretty);
+		pj_deleteArray(array);
+	}
+	else
+	{
+		pj_Object* obj = pj_parseObjEx(text, flags);
+		result = objString(obj, isPretty);
+		pj_deleteObj(obj);
+	}
+
+	pj_setParseEngine(PJ_ENGINE_RECURSIVE);
+	return result;
+}
+
+static void testEngines()
+{
+	for (const char* text : validDocuments)
+	{
+		for (unsigned int flags : { PJ_PARSE_DEFAULT, PJ_PARSE_ARENA, PJ_PARSE_INTERN_KEYS })
+		{
+			for (bool isPretty : { false, true })
+			{
+				const std::string recursive = parseWith(text, PJ_ENGINE_RECURSIVE, flags, isPretty);
+				const std::string indexed = parseWith(text, PJ_ENGINE_STRUCTURAL_INDEX, flags, isPretty);
+
+				CHECK(recursive != "<null>");
+				CHECK(recursive == indexed);
+			}
+		}
+
+		CHECK(pj_popError() == nullptr);
+	}
+}
+
+static const char* const malformedDocuments[] =
+{
+	"{\"a\":1,}", "[1,]", "{\"a\":[1,]}", "[{\"a\":1,}]", "{,}", "[,]", "[1,,2]",
+	"{\"a\" 1}", "{\"a\":}", "{\"a\":1 \"b\":2}", "[1 2]", "{1:2}", "[}", "{]",
+	"{\"a\":1", "[1", "[[]", "{\"a\":tru}", "[nul]", "[1.]", "[-]", "[01]", "[.5]", "[+1]", "[1e]", "[1e+]", "[0x1]", "[\"\\x\"]",
+};
+
+static bool failsWith(const char* text, pj_ParseEngine engine)
+{
+	clearErrors();
+	parseWith(text, engine, PJ_PARSE_DEFAULT, false);
+
+	const bool failed = pj_popError() != nullptr;
+	clearErrors();
+	return failed;
+}
+
+static void testMalformed()
+{
+	for (const char* text : malformedDocuments)
+	{
+		CHECK(failsWith(text, PJ_ENGINE_RECURSIVE));
+		CHECK(failsWith(text, PJ_ENGINE_STRUCTURAL_INDEX));
+	}
+}
+
+static bool sameDouble(double a, double b)
+{
+	return memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+static void testNumbers()
+{
+	std::vector<std::string> numbers = { "0", "-0", "0.1", "-1.5", "1e308", "5e-324", "2.2250738585072014e-308",
+		"1.7976931348623157e308", "9007199254740993", "123456.789e-300", "3.141592653589793", "1E2", "1e+2",
+		"0.30000000000000004", "100000000000000000000000", "9223372036854775808", "1e400", "-1e-400",
+		"0.000000000000000000000000000001234567890123456789012", "123456789012345678901234567890e-10" };
+
+	std::mt19937_64 rng(42);
+	for (int i = 0; i < 10000; i++)
+	{
+		const uint64_t bits = rng();
+		double num;
+		memcpy(&num, &bits, sizeof(num));
+		if (!std::isfinite(num)) continue;
+
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), i % 2 ? "%.17g" : "%.15e", num);
+		numbers.push_back(buffer);
+	}
+
+	std::string text = "[";
+	for (const std::string& num : numbers) text += (text.size() > 1 ? "," : "") + num;
+	text += "]";
+
+	// every number is parsed to the double closest to it, as strtod does
+	pj_Array* parsed = pj_parseArray(text.c_str());
+	CHECK(pj_getArraySize(parsed) == numbers.size());
+	for (size_t i = 0; i < numbers.size() && i < pj_getArraySize(parsed); i++)
+	{
+		if (!sameDouble(pj_arrayGetNum(parsed, i), strtod(numbers[i].c_str(), nullptr)))
+		{
+			std::cerr << "number " << numbers[i] << " was parsed as " << pj_arrayGetNum(parsed, i) << std::endl;
+			CHECK(false);
+			break;
+		}
+	}
+	pj_deleteArray(parsed);
+
+	// integers stay exact as long as they fit in 64 bits
+	parsed = pj_parseArray("[9223372036854775807, -9223372036854775808, 9223372036854775808, 9007199254740993, 1E2, -0]");
+	CHECK(pj_arrayGetInt64(parsed, 0) == INT64_MAX);
+	CHECK(pj_arrayGetInt64(parsed, 1) == INT64_MIN);
+	CHECK(pj_getArrayElemType(parsed, 0) == PJ_VALUE_INT64);
+	CHECK(pj_getArrayElemType(parsed, 2) == PJ_VALUE_NUMBER);
+	CHECK(sameDouble(pj_arrayGetNum(parsed, 2), 9223372036854775808.0));
+	CHECK(pj_arrayGetInt64(parsed, 3) == 9007199254740993);
+	CHECK(pj_getArrayElemType(parsed, 4) == PJ_VALUE_NUMBER);
+	CHECK(pj_arrayGetInt64(parsed, 4) == 100);
+	CHECK(sameDouble(pj_arrayGetNum(parsed, 5), -0.0));
+
+	pj_arrayAddInt64(parsed, INT64_MIN + 1);
+	CHECK(pj_arrayGetInt64(parsed, 6) == INT64_MIN + 1);
+
+	pj_Array* again = pj_parseArray(arrayString(parsed).c_str());
+	CHECK(pj_arrayGetInt64(again, 0) == INT64_MAX);
+	CHECK(pj_arrayGetInt64(again, 1) == INT64_MIN);
+	CHECK(pj_arrayGetInt64(again, 3) == 9007199254740993);
+	CHECK(pj_arrayGetInt64(again, 6) == INT64_MIN + 1);
+	pj_deleteArray(again);
+	pj_deleteArray(parsed);
+
+	// doubles are written with the fewest digits that read back to the same value
+	pj_Array* array = pj_createArray();
+	for (const std::string& num : numbers)
+	{
+		const double value = strtod(num.c_str(), nullptr);
+		if (std::isfinite(value)) pj_arrayAddNum(array, value);
+	}
+
+	parsed = pj_parseArray(arrayString(array).c_str());
+	CHECK(pj_getArraySize(parsed) == pj_getArraySize(array));
+	for (size_t i = 0; i < pj_getArraySize(array) && i < pj_getArraySize(parsed); i++)
+	{
+		if (!sameDouble(pj_arrayGetNum(parsed, i), pj_arrayGetNum(array, i)))
+		{
+			std::cerr << "number " << pj_arrayGetNum(array, i) << " did not round trip" << std::endl;
+			CHECK(false);
+			break;
+		}
+	}
+	pj_deleteArray(parsed);
+	pj_deleteArray(array);
+
+	parsed = pj_parseArray("[9223372036854775807, -9223372036854775808, 9223372036854775808, 0.30000000000000004, 1E2, 100000000000000000000000, 5e-324, 1.5e300, -0.0]");
+	CHECK(arrayString(parsed) == "[9223372036854775807,-9223372036854775808,9223372036854776000,0.30000000000000004,100,1e23,5e-324,1.5e300,-0]");
+	pj_deleteArray(parsed);
+
+	CHECK(pj_popError() == nullptr);
+}
+
+static size_t appendSink(void* out, const char* data, size_t length)
+{
+	((std::string*)out)->append(data, length);
+	return length;
+}
+
+static std::string readBack(FILE* file)
+{
+	fflush(file);
+	rewind(file);
+
+	std::string text;
+	char buffer[4096];
+	size_t length;
+	while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) text.append(buffer, length);
+
+	fclose(file);
+	return text;
+}
+
+static void testBuilder()
+{
+	// every object has at most one member, so the tree serializer keeps the same order
+	const char* text = "{\"a\": [[], {}, 1.5, -7, \"s\\\"\\n\", true, null, {\"b\": [false, {}]}], \"c\\t\": 0}";
+	pj_Object* expected = pj_parseObj("{\"a\": [[], {}, 1.5, -7, \"s\\\"\\n\", true, null, {\"b\": [false, {}]}]}");
+	pj_Array* embedded = pj_parseArray("[{\"x\": []}, [1, 2]]");
+
+	for (bool isPretty : { false, true })
+	{
+		std::string out;
+		pj_Builder* builder = pj_createBuilder(isPretty, appendSink, &out);
+		pj_builderBeginObject(builder);
+		pj_builderKey(builder, "a");
+		pj_builderBeginArray(builder);
+		pj_builderBeginArray(builder);
+		pj_builderEndArray(builder);
+		pj_builderBeginObject(builder);
+		pj_builderEndObject(builder);
+		pj_builderNum(builder, 1.5);
+		pj_builderInt64(builder, -7);
+		pj_builderString(builder, "s\"\n");
+		pj_builderBool(builder, true);
+		pj_builderNull(builder);
+		pj_builderBeginObject(builder);
+		pj_builderKey(builder, "b");
+		pj_builderBeginArray(builder);
+		pj_builderBool(builder, false);
+		pj_builderBeginObject(builder);
+		pj_builderEndObject(builder);
+		pj_builderEndArray(builder);
+		pj_builderEndObject(builder);
+		pj_builderEndArray(builder);
+		pj_builderEndObject(builder);
+		CHECK(pj_finishBuilder(builder));
+
+		// pretty output is laid out like the tree serializer, empty containers included
+		CHECK(out == objString(expected, isPretty));
+
+		out.clear();
+		builder = pj_createBuilder(isPretty, appendSink, &out);
+		pj_builderArray(builder, embedded);
+		CHECK(pj_finishBuilder(builder));
+		CHECK(out == arrayString(embedded, isPretty));
+	}
+
+	// a whole document is written as the tree serializer writes it
+	pj_Object* parsed = pj_parseObj(text);
+	std::string out;
+	pj_Builder* builder = pj_createBuilder(true, appendSink, &out);
+	pj_builderObj(builder, parsed);
+	CHECK(pj_finishBuilder(builder));
+	CHECK(out == objString(parsed, true));
+
+	// calls that do not form one value are reported
+	builder = pj_createBuilder(false, appendSink, &out);
+	pj_builderBeginObject(builder);
+	pj_builderNum(builder, 1);
+	CHECK(!pj_finishBuilder(builder));
+	CHECK(pj_popError() != nullptr);
+	clearErrors();
+
+	builder = pj_createBuilder(false, appendSink, &out);
+	pj_builderBeginArray(builder);
+	pj_builderEndObject(builder);
+	CHECK(!pj_finishBuilder(builder));
+	clearErrors();
+
+	builder = pj_createBuilder(false, appendSink, &out);
+	pj_builderNull(builder);
+	pj_builderNull(builder);
+	CHECK(!pj_finishBuilder(builder));
+	clearErrors();
+
+	builder = pj_createBuilder(false, appendSink, &out);
+	pj_builderBeginArray(builder);
+	CHECK(!pj_finishBuilder(builder));
+	clearErrors();
+
+	pj_deleteObj(parsed);
+	pj_deleteArray(embedded);
+	pj_deleteObj(expected);
+
+	CHECK(pj_popError() == nullptr);
+}
+
+static void testSinks()
+{
+	// large enough to flush the stream buffer many times
+	pj_Array* array = pj_createArray();
+	for (int i = 0; i < 20000; i++)
+	{
+		pj_Object* obj = pj_createObj();
+		pj_objSetString(obj, "name", ("item " + std::to_string(i)).c_str());
+		pj_objSetInt64(obj, "id", i);
+		pj_arrayAddObj(array, obj);
+	}
+
+	pj_Object* obj = pj_parseObj("{\"a\": [1, {\"b\": \"c\"}], \"d\": {}}");
+
+	for (bool isPretty : { false, true })
+	{
+		const std::string expected = arrayString(array, isPretty);
+
+		std::string out;
+		CHECK(pj_arrayToCallback(array, isPretty, appendSink, &out));
+		CHECK(out == expected);
+
+		FILE* file = tmpfile();
+		CHECK(pj_arrayToFd(array, isPretty, fileno(file)));
+		CHECK(readBack(file) == expected);
+
+		file = tmpfile();
+		CHECK(pj_arrayToStream(array, isPretty, file));
+		CHECK(readBack(file) == expected);
+
+		file = tmpfile();
+		CHECK(pj_objToFd(obj, isPretty, fileno(file)));
+		CHECK(readBack(file) == objString(obj, isPretty));
+
+		file = tmpfile();
+		pj_Builder* builder = pj_createFdBuilder(isPretty, fileno(file));
+		pj_builderArray(builder, array);
+		CHECK(pj_finishBuilder(builder));
+		CHECK(readBack(file) == expected);
+	}
+
+	pj_deleteObj(obj);
+	pj_deleteArray(array);
+
+	CHECK(pj_popError() == nullptr);
+}
+
+// every callback appends to the string it is given, so two runs can be compared
+static pj_SaxCallbacks recordingCallbacks()
+{
+	pj_SaxCallbacks callbacks = {};
+	callbacks.startObject = [](void* events) { *(std::string*)events += "{"; };
+	callbacks.endObject = [](void* events) { *(std::string*)events += "}"; };
+	callbacks.startArray = [](void* events) { *(std::string*)events += "["; };
+	callbacks.endArray = [](void* events) { *(std::string*)events += "]"; };
+	callbacks.key = [](void* events, const char* key, size_t length) { *(std::string*)events += "k:" + std::string(key, length) + ";"; };
+	callbacks.string = [](void* events, const char* str, size_t length) { *(std::string*)events += "s:" + std::string(str, length) + ";"; };
+	callbacks.number = [](void* events, double num) { *(std::string*)events += "n:" + std::to_string(num) + ";"; };
+	callbacks.int64 = [](void* events, int64_t num) { *(std::string*)events += "i:" + std::to_string(num) + ";"; };
+	callbacks.boolean = [](void* events, pj_boolean boolean) { *(std::string*)events += boolean ? "true;" : "false;"; };
+	callbacks.null = [](void* events) { *(std::string*)events += "null;"; };
+	return callbacks;
+}
+
+static bool runSax(const std::string& text, size_t cut, std::string& events)
+{
+	const pj_SaxCallbacks callbacks = recordingCallbacks();
+	pj_SaxParser* parser = pj_createSaxParser(&callbacks, &events);
+
+	bool ok = pj_saxParserFeed(parser, text.data(), cut);
+	ok = pj_saxParserFeed(parser, text.data() + cut, text.size() - cut) && ok;
+	ok = pj_saxParserFinish(parser) && ok;
+
+	pj_deleteSaxParser(parser);
+	return ok;
+}
+
+static void testSax()
+{
+	const std::string text = "{\"name\": \"caf\\u00e9 \\\"x\\\"\", \"values\": [1, -2.5e3, 123456789012, true, false, null],"
+		" \"nested\": {\"a\": [{}, []], \"escaped\\nkey\": \"\\ud83d\\ude00\"}, \"last\": 0.125}";
+
+	std::string reference;
+	CHECK(runSax(text, text.size(), reference));
+	CHECK(reference.find("s:caf\xC3\xA9 \"x\";") != std::string::npos);
+	CHECK(reference.find("i:123456789012;") != std::string::npos);
+
+	for (size_t cut = 0; cut <= text.size(); cut++)
+	{
+		std::string events;
+		const bool ok = runSax(text, cut, events);
+		CHECK(ok);
+		CHECK(events == reference);
+		if (!ok || events != reference)
+		{
+			std::cerr << "sax cut at " << cut << std::endl;
+			break;
+		}
+	}
+
+	// one byte at a time
+	{
+		std::string events;
+		const pj_SaxCallbacks callbacks = recordingCallbacks();
+		pj_SaxParser* parser = pj_createSaxParser(&callbacks, &events);
+
+		bool ok = true;
+		for (char c : text) ok = pj_saxParserFeed(parser, &c, 1) && ok;
+		ok = pj_saxParserFinish(parser) && ok;
+		pj_deleteSaxParser(parser);
+
+		CHECK(ok);
+		CHECK(events == reference);
+	}
+
+	std::string events;
+	CHECK(!runSax("{\"a\": [1 2]}", 6, events));
+	CHECK(!runSax("[1, 2", 2, events));
+	clearErrors();
+}
+
+static void writeFile(const char* fileName, const std::string& text)
+{
+	FILE* file = fopen(fileName, "wb");
+	fwrite(text.data(), 1, text.size(), file);
+	fclose(file);
+}
+
+static std::string readFile(const char* fileName)
+{
+	return readBack(fopen(fileName, "rb"));
+}
+
+static void testFiles()
+{
+	const char* fileName = "JsonTest.tmp.json";
+
+	// strings are decoded inside the mapping, the file keeps its escapes
+	const std::string text = "{\"a\\u0041\": [\"x\\ty\", {\"b\": 2}], \"c\": \"\\ud83d\\ude00\"}";
+	writeFile(fileName, text);
+
+	pj_Object* obj = pj_parseObjFile(fileName);
+	CHECK(strcmp(pj_arrayGetString(pj_objGetArray(obj, "aA"), 0), "x\ty") == 0);
+	CHECK(strcmp(pj_objGetString(obj, "c"), "\xF0\x9F\x98\x80") == 0);
+	CHECK(readFile(fileName) == text);
+	pj_deleteObj(obj);
+
+	// a file that fills its last page exactly still ends where it should
+	std::string padded = "[1, \"two\", [3]";
+	padded += std::string(4096 - padded.size() - 1, ' ') + "]";
+	writeFile(fileName, padded);
+
+	pj_Array* array = pj_parseArrayFile(fileName);
+	CHECK(pj_getArraySize(array) == 3);
+	CHECK(pj_arrayGetNum(pj_arrayGetArray(array, 2), 0) == 3);
+	pj_deleteArray(array);
+
+	// written out and read back
+	array = pj_parseArray("[{\"k\": [true, null, -1.25]}, \"\\\"\"]");
+	CHECK(pj_arrayToFile(array, true, fileName));
+	pj_Array* again = pj_parseArrayFile(fileName);
+	CHECK(arrayString(again) == arrayString(array));
+	pj_deleteArray(again);
+	pj_deleteArray(array);
+
+	CHECK(pj_popError() == nullptr);
+
+	// like an empty string, an empty file has no root
+	writeFile(fileName, "");
+	CHECK(pj_parseObjFile(fileName) == nullptr);
+
+	remove(fileName);
+	CHECK(pj_parseArrayFile(fileName) == nullptr);
+	CHECK(pj_popError() != nullptr);
+	clearErrors();
+}
+
+// Copies text right in front of an unreadable page, so reading past its end crashes. Without
+// mmap it is copied to a buffer of exactly its size instead, which sanitizers watch
+struct GuardedInput
+{
+	char* data;
+	char* mapping = nullptr;
+	size_t mappingSize = 0;
+
+	GuardedInput(const std::string& text)
+	{
+#if !defined(_WIN32) && !defined(_WIN64)
+		const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+		mappingSize = (text.size() / page + 2) * page;
+		mapping = (char*)mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		mprotect(mapping + mappingSize - page, page, PROT_NONE);
+		data = mapping + mappingSize - page - text.size();
+#else
+		data = new char[text.size()];
+#endif
+		memcpy(data, text.data(), text.size());
+	}
+
+	~GuardedInput()
+	{
+#if !defined(_WIN32) && !defined(_WIN64)
+		munmap(mapping, mappingSize);
+#else
+		delete[] data;
+#endif
+	}
+};
+
+static void testLengthBounded()
+{
+	// all of these end in the middle of a value, right where the input does
+	const char* const inputs[] =
+	{
+		"[0.0000000000000000000", "{\"a\":0.0000000000000000000", "[00000000000000000000000",
+		"[1e", "[1e-", "[-", "[\"abc", "[\"\\u00", "{\"key", "[tru", "[1, 2",
+	};
+
+	for (const char* input : inputs)
+	{
+		const std::string text = input;
+		GuardedInput guarded(text);
+
+		for (pj_ParseEngine engine : { PJ_ENGINE_RECURSIVE, PJ_ENGINE_STRUCTURAL_INDEX })
+		{
+			pj_setParseEngine(engine);
+			pj_deleteArray(pj_parseArrayN(guarded.data, text.size()));
+			pj_deleteObj(pj_parseObjN(guarded.data, text.size()));
+		}
+		pj_setParseEngine(PJ_ENGINE_RECURSIVE);
+
+		pj_deleteArray(pj_parseArrayParallel(guarded.data, text.size(), PJ_PARSE_DEFAULT, 2));
+		pj_deleteArray(pj_parseNdjsonArray(guarded.data, text.size(), PJ_PARSE_DEFAULT, 2, nullptr));
+
+		CHECK(pj_popError() != nullptr);
+		clearErrors();
+	}
+
+	// a complete value that ends exactly at the end of the input
+	const std::string text = "[0.00000000000000000000000000001]";
+	GuardedInput guarded(text);
+	pj_Array* array = pj_parseArrayN(guarded.data, text.size());
+	CHECK(pj_arrayGetNum(array, 0) == 1e-29);
+	pj_deleteArray(array);
+	CHECK(pj_popError() == nullptr);
+
+	// whatever follows the slice makes no difference
+	const char* sliced = "{\"a\": [1, 2]}]\"}, \"b\": 3}";
+	for (pj_ParseEngine engine : { PJ_ENGINE_RECURSIVE, PJ_ENGINE_STRUCTURAL_INDEX })
+	{
+		pj_setParseEngine(engine);
+		pj_Object* obj = pj_parseObjN(sliced, 13);
+		CHECK(objString(obj) == "{\"a\": [1,2]}");
+		pj_deleteObj(obj);
+
+		pj_deleteObj(pj_parseObjN(sliced, 12));
+		CHECK(pj_popError() != nullptr);
+		clearErrors();
+	}
+	pj_setParseEngine(PJ_ENGINE_RECURSIVE);
+}
+
+static size_t keysVisited = 0;
+
+static void testObjects()
+{
+	// small objects are scanned in order, larger ones become a hash table
+	for (int count : { 0, 1, 15, 16, 17, 100, 3000 })
+	{
+		std::string text = "{";
+		for (int i = 0; i < count; i++) text += (i ? ", \"key" : "\"key") + std::to_string(i) + "\": " + std::to_string(i);
+		text += "}";
+
+		for (unsigned int flags : { PJ_PARSE_DEFAULT, PJ_PARSE_ARENA })
+		{
+			pj_Object* obj = pj_parseObjEx(text.c_str(), flags);
+			pj_Object* built = pj_createObj();
+
+			bool found = true;
+			for (int i = 0; i < count; i++)
+			{
+				const std::string key = "key" + std::to_string(i);
+				found = found && pj_objGetNum(obj, key.c_str()) == i;
+				pj_objSetNum(built, key.c_str(), -1);
+				pj_objSetNum(built, key.c_str(), i);
+			}
+			CHECK(found);
+
+			// keys that share a prefix, a length or nothing with the members
+			CHECK(!pj_isObjPropOfType(obj, "key", PJ_VALUE_NUMBER));
+			CHECK(!pj_isObjPropOfType(obj, "ke", PJ_VALUE_NUMBER));
+			CHECK(!pj_isObjPropOfType(obj, ("key" + std::to_string(count)).c_str(), PJ_VALUE_NUMBER));
+			CHECK(!pj_isObjPropOfType(obj, "", PJ_VALUE_NUMBER));
+
+			keysVisited = 0;
+			pj_objForEachKey(built, [](pj_Object*, const char*) { keysVisited++; });
+			CHECK(keysVisited == (size_t)count);
+
+			pj_Object* again = pj_parseObj(objString(built).c_str());
+			for (int i = 0; i < count; i++) found = found && pj_objGetNum(again, ("key" + std::to_string(i)).c_str()) == i;
+			CHECK(found);
+
+			pj_deleteObj(again);
+			pj_deleteObj(built);
+			pj_deleteObj(obj);
+		}
+	}
+
+	// members come out in the order they were added, overwriting keeps the place
+	std::string expected = "{";
+	pj_Object* obj = pj_createObj();
+	for (int i = 0; i < 40; i++)
+	{
+		const std::string key = std::to_string((i * 7919) % 40);
+		pj_objSetNum(obj, key.c_str(), i);
+		expected += (i ? ",\"" : "\"") + key + "\": " + std::to_string(i == 3 ? 99 : i);
+	}
+	expected += "}";
+
+	pj_objSetNum(obj, std::to_string((3 * 7919) % 40).c_str(), 99);
+	CHECK(objString(obj) == expected);
+
+	pj_Object* parsed = pj_parseObj(expected.c_str());
+	CHECK(objString(parsed) == expected);
+	pj_deleteObj(parsed);
+	pj_deleteObj(obj);
+
+	CHECK(pj_popError() == nullptr);
+}
+
+static const char* lastKey = nullptr;
+
+static void testInterning()
+{
+	pj_Array* array = pj_parseArrayEx("[{\"name\": 1, \"id\": 2}, {\"id\": 3, \"name\": 4}, {\"na\\u006de\": 5}]", PJ_PARSE_INTERN_KEYS);
+
+	// the same key is stored once per document
+	const char* keys[3];
+	for (size_t i = 0; i < 3; i++)
+	{
+		lastKey = nullptr;
+		pj_objForEachKey(pj_arrayGetObj(array, i), [](pj_Object*, const char* key) { if (strcmp(key, "name") == 0) lastKey = key; });
+		keys[i] = lastKey;
+	}
+	CHECK(keys[0] && keys[0] == keys[1] && keys[1] == keys[2]);
+
+	pj_objSetNum(pj_arrayGetObj(array, 0), "name", 6);
+	pj_objSetNum(pj_arrayGetObj(array, 0), "added", 7);
+	CHECK(pj_objGetNum(pj_arrayGetObj(array, 0), "name") == 6);
+	CHECK(pj_objGetNum(pj_arrayGetObj(array, 1), "name") == 4);
+	CHECK(pj_objGetNum(pj_arrayGetObj(array, 0), "added") == 7);
+	CHECK(arrayString(array) == "[{\"name\": 6,\"id\": 2,\"added\": 7},{\"id\": 3,\"name\": 4},{\"name\": 5}]");
+	pj_deleteArray(array);
+
+	CHECK(pj_popError() == nullptr);
+}
+
+struct Extracted
+{
+	double score;
+	int64_t id;
+	const char* name;
+	const char* slashed;
+	pj_boolean active;
+	pj_Array* tags;
+	const char* missing;
+};
+
+static void testPaths()
+{
+	pj_Object* obj = pj_parseObj("{\"user\": {\"id\": 7, \"name\": \"ann\", \"active\": true, \"tags\": [\"x\", {\"deep\": 2.5}]},"
+		" \"a/b\": {\"m~n\": \"escaped\"}, \"score\": 0.5}");
+
+	pj_Path* dotted = pj_compilePath("user.tags.1.deep");
+	pj_Path* pointer = pj_compilePath("/user/tags/1/deep");
+	pj_Path* escaped = pj_compilePath("/a~1b/m~0n");
+	pj_Path* missing = pj_compilePath("/user/nothing");
+	pj_Path* outOfRange = pj_compilePath("user.tags.5");
+
+	CHECK(pj_objGetNumAt(obj, dotted) == 2.5);
+	CHECK(pj_objGetNumAt(obj, pointer) == 2.5);
+	CHECK(pj_objGetStringAt(obj, escaped) && strcmp(pj_objGetStringAt(obj, escaped), "escaped") == 0);
+	CHECK(pj_objGetStringAt(obj, missing) == nullptr);
+	CHECK(pj_objGetObjAt(obj, outOfRange) == nullptr);
+	CHECK(pj_objGetInt64(obj, "user.id") == 7);
+	CHECK(strcmp(pj_objGetString(obj, "user.name"), "ann") == 0);
+
+	// ~ must be followed by 0 or 1
+	CHECK(pj_compilePath("/a~2b") == nullptr);
+	const char* error = pj_popError();
+	CHECK(error && strstr(error, "PATH :: "));
+
+	pj_Array* array = pj_parseArray("[[10, 20], {\"k\": [30]}]");
+	pj_Path* inArray = pj_compilePath("/1/k/0");
+	CHECK(pj_arrayGetInt64At(array, inArray) == 30);
+	pj_deletePath(inArray);
+	pj_deleteArray(array);
+
+	const pj_Field fields[] =
+	{
+		{ "score", PJ_VALUE_NUMBER, offsetof(Extracted, score) },
+		{ "user.id", PJ_VALUE_INT64, offsetof(Extracted, id) },
+		{ "/user/name", PJ_VALUE_STRING, offsetof(Extracted, name) },
+		{ "/a~1b/m~0n", PJ_VALUE_STRING, offsetof(Extracted, slashed) },
+		{ "user.active", PJ_VALUE_BOOL, offsetof(Extracted, active) },
+		{ "user.tags", PJ_VALUE_ARRAY, offsetof(Extracted, tags) },
+		{ "user.missing", PJ_VALUE_STRING, offsetof(Extracted, missing) },
+	};
+
+	pj_Extractor* extractor = pj_compileExtractor(fields, sizeof(fields) / sizeof(fields[0]));
+	Extracted out = {};
+	out.missing = "untouched";
+
+	CHECK(pj_objExtract(obj, extractor, &out) == 6);
+	CHECK(out.score == 0.5);
+	CHECK(out.id == 7);
+	CHECK(out.name && strcmp(out.name, "ann") == 0);
+	CHECK(out.slashed && strcmp(out.slashed, "escaped") == 0);
+	CHECK(out.active);
+	CHECK(pj_getArraySize(out.tags) == 2);
+	CHECK(out.missing == nullptr);
+
+	pj_deleteExtractor(extractor);
+
+	// array elements are reached by index, the same fields fail in the same way
+	const pj_Field elementFields[] =
+	{
+		{ "0", PJ_VALUE_INT64, offsetof(Extracted, id) },
+		{ "/1/name", PJ_VALUE_STRING, offsetof(Extracted, name) },
+		{ "1.tags", PJ_VALUE_ARRAY, offsetof(Extracted, tags) },
+		{ "2", PJ_VALUE_NUMBER, offsetof(Extracted, score) },
+		{ "1.name.x", PJ_VALUE_STRING, offsetof(Extracted, missing) },
+	};
+
+	pj_Array* elements = pj_parseArray("[42, {\"name\": \"bob\", \"tags\": []}, \"not a number\"]");
+	pj_Extractor* elementExtractor = pj_compileExtractor(elementFields, sizeof(elementFields) / sizeof(elementFields[0]));
+	Extracted element = {};
+	element.score = 1;
+	element.missing = "untouched";
+
+	CHECK(pj_arrayExtract(elements, elementExtractor, &element) == 3);
+	CHECK(element.id == 42);
+	CHECK(element.name && strcmp(element.name, "bob") == 0);
+	CHECK(pj_getArraySize(element.tags) == 0);
+	CHECK(element.score == 0);
+	CHECK(element.missing == nullptr);
+
+	pj_deleteExtractor(elementExtractor);
+	pj_deleteArray(elements);
+	pj_deletePath(outOfRange);
+	pj_deletePath(missing);
+	pj_deletePath(escaped);
+	pj_deletePath(pointer);
+	pj_deletePath(dotted);
+	pj_deleteObj(obj);
+
+	CHECK(pj_popError() == nullptr);
+}
+
+static void testLazy()
+{
+	const char* text = "{\"kind\": \"event\", \"payload\": {\"user\": {\"id\": 7, \"tags\": [\"a\", \"]\\\"}\"]}, \"score\": 2.5},"
+		" \"items\": [[1, 2], {\"k\": \"v\"}, []], \"empty\": {}}";
+
+	pj_Object* eager = pj_parseObj(text);
+	pj_Path* path = pj_compilePath("/payload/user/tags/1");
+
+	// the input is copied, so the caller's buffer can go away before anything is read
+	std::string buffer = text;
+	pj_Object* lazy = pj_parseObjEx(buffer.c_str(), PJ_PARSE_LAZY);
+	buffer.assign(buffer.size(), 'x');
+
+	CHECK(pj_objGetNum(pj_objGetObj(lazy, "payload"), "score") == 2.5);
+	CHECK(pj_objGetInt64(pj_objGetObj(pj_objGetObj(lazy, "payload"), "user"), "id") == 7);
+	CHECK(strcmp(pj_objGetStringAt(lazy, path), "]\"}") == 0);
+	CHECK(pj_getArraySize(pj_arrayGetArray(pj_objGetArray(lazy, "items"), 0)) == 2);
+	CHECK(strcmp(pj_objGetString(pj_arrayGetObj(pj_objGetArray(lazy, "items"), 1), "k"), "v") == 0);
+	CHECK(objString(lazy, true) == objString(eager, true));
+	pj_deleteObj(lazy);
+
+	// compiled paths and extractors reach into values nobody touched yet
+	lazy = pj_parseObjEx(text, PJ_PARSE_LAZY);
+	CHECK(strcmp(pj_objGetStringAt(lazy, path), "]\"}") == 0);
+	pj_deleteObj(lazy);
+
+	const pj_Field fields[] =
+	{
+		{ "payload.score", PJ_VALUE_NUMBER, offsetof(Extracted, score) },
+		{ "/payload/user/id", PJ_VALUE_INT64, offsetof(Extracted, id) },
+		{ "payload.user.tags", PJ_VALUE_ARRAY, offsetof(Extracted, tags) },
+		{ "kind", PJ_VALUE_STRING, offsetof(Extracted, name) },
+	};
+	pj_Extractor* extractor = pj_compileExtractor(fields, sizeof(fields) / sizeof(fields[0]));
+
+	lazy = pj_parseObjEx(text, PJ_PARSE_LAZY);
+	Extracted out = {};
+	CHECK(pj_objExtract(lazy, extractor, &out) == 4);
+	CHECK(out.score == 2.5);
+	CHECK(out.id == 7);
+	CHECK(pj_getArraySize(out.tags) == 2);
+	CHECK(out.name && strcmp(out.name, "event") == 0);
+
+	// edits land in the parsed values, untouched ones are still written as they came in
+	pj_objSetNum(pj_objGetObj(lazy, "payload"), "score", 3);
+	pj_arrayAddNull(pj_objGetArray(lazy, "items"));
+	pj_objSetNum(pj_objGetObj(eager, "payload"), "score", 3);
+	pj_arrayAddNull(pj_objGetArray(eager, "items"));
+	CHECK(objString(lazy).find("\"items\": [[1, 2],") != std::string::npos);
+
+	pj_Object* reparsed = pj_parseObj(objString(lazy).c_str());
+	CHECK(objString(reparsed) == objString(eager));
+	pj_deleteObj(reparsed);
+	pj_deleteObj(lazy);
+
+	pj_Array* array = pj_parseArrayEx("[{\"a\": [1, {\"b\": true}]}, [[\"c\"]]]", PJ_PARSE_LAZY);
+	CHECK(pj_objGetBool(pj_arrayGetObj(pj_objGetArray(pj_arrayGetObj(array, 0), "a"), 1), "b"));
+	CHECK(strcmp(pj_arrayGetString(pj_arrayGetArray(pj_arrayGetArray(array, 1), 0), 0), "c") == 0);
+	pj_deleteArray(array);
+
+	CHECK(pj_popError() == nullptr);
+
+	// a deferred value is only checked once it is read
+	lazy = pj_parseObjEx("{\"bad\": [1 2], \"good\": 1}", PJ_PARSE_LAZY);
+	CHECK(pj_popError() == nullptr);
+	CHECK(pj_objGetNum(lazy, "good") == 1);
+	pj_objGetArray(lazy, "bad");
+	CHECK(pj_popError() != nullptr);
+	clearErrors();
+	pj_deleteObj(lazy);
+
+	pj_deleteExtractor(extractor);
+	pj_deletePath(path);
+	pj_deleteObj(eager);
+}
+
+static void testKeepSource()
+{
+	const char* text = "{\"a\":  {\"x\":1,\"y\" : [1,2]},\n \"b\":[ 3 ,4 ],\"c\":\"s\"}";
+
+	for (unsigned int flags : { PJ_PARSE_KEEP_SOURCE, PJ_PARSE_LAZY })
+	{
+		pj_Object* obj = pj_parseObjEx(text, flags);
+		CHECK(objString(obj) == text);
+		CHECK(objString(pj_objGetObj(obj, "a")) == "{\"x\":1,\"y\" : [1,2]}");
+
+		// the edited object and its parents are serialized again, the rest is still copied
+		pj_objSetNum(pj_objGetObj(obj, "a"), "z", 5);
+		CHECK(objString(obj) == "{\"a\": {\"x\": 1,\"y\": [1,2],\"z\": 5},\"b\": [ 3 ,4 ],\"c\": \"s\"}");
+
+		pj_Object* plain = pj_parseObj(text);
+		pj_objSetNum(pj_objGetObj(plain, "a"), "z", 5);
+
+		// reparsed, both edits come out the same
+		pj_Object* again = pj_parseObj(objString(obj).c_str());
+		CHECK(objString(again) == objString(plain));
+		CHECK(objString(obj, true) == objString(plain, true));
+
+		pj_deleteObj(again);
+		pj_deleteObj(plain);
+		pj_deleteObj(obj);
+	}
+
+	// documents with errors have no source to copy
+	pj_Object* invalid = pj_parseObjEx("{\"a\": [1 2], \"b\": 1}", PJ_PARSE_KEEP_SOURCE);
+	CHECK(pj_popError() != nullptr);
+	CHECK(objString(invalid).find("1 2") == std::string::npos);
+	pj_deleteObj(invalid);
+	clearErrors();
+}
+
+static void testThreadErrors()
+{
+	pj_deleteObj(pj_parseObj("{\"a\": [1 2]}"));
+
+	// errors raised on another thread stay on that thread
+	bool otherOk = false;
+	std::thread other([&]()
+	{
+		otherOk = pj_popError() == nullptr;
+		pj_deleteObj(pj_parseObj("{\"b\": 1 \"c\": 2}"));
+		otherOk = otherOk && pj_popError() != nullptr;
+		clearErrors();
+	});
+	other.join();
+
+	CHECK(otherOk);
+	const char* error = pj_popError();
+	CHECK(error && strstr(error, "Missing comma after property value"));
+	clearErrors();
+}
+
+static void testNdjson()
+{
+	const std::string text = "{\"a\": 1}\n\n  [1, 2]\r\n{\"s\": \"x\\ny\"}\n{\"multi\": \"line\nin string\"}\n42\n{\"last\": true}";
+
+	for (unsigned int threads : { 1u, 3u })
+	{
+		size_t count = 0;
+		pj_Array* records = pj_parseNdjsonArray(text.data(), text.size(), PJ_PARSE_DEFAULT, threads, &count);
+
+		CHECK(count == 6);
+		CHECK(pj_getArraySize(records) == 6);
+		CHECK(pj_objGetNum(pj_arrayGetObj(records, 0), "a") == 1);
+		CHECK(pj_getArraySize(pj_arrayGetArray(records, 1)) == 2);
+		CHECK(strcmp(pj_objGetString(pj_arrayGetObj(records, 2), "s"), "x\ny") == 0);
+		CHECK(strcmp(pj_objGetString(pj_arrayGetObj(records, 3), "multi"), "line\nin string") == 0);
+		CHECK(pj_getArrayElemType(records, 4) == PJ_VALUE_NULL);
+		CHECK(pj_objGetBool(pj_arrayGetObj(records, 5), "last"));
+		pj_deleteArray(records);
+
+		// 42 comes after a string with a newline in it, on line 6 counting from 0
+		const char* error = pj_popError();
+		CHECK(error && strstr(error, "NDJSON :: ") == error && strstr(error, "RECORD LINENO: 6"));
+		CHECK(pj_popError() == nullptr);
+	}
+}
+
+static std::string makeRecords(size_t count)
+{
+	std::mt19937 rng(7);
+	std::string text = "[";
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (i) text += i % 7 ? "," : ",\n";
+		switch (rng() % 4)
+		{
+		case 0: text += "{\"id\": " + std::to_string(i) + ", \"name\": \"a,b]}[{\\\" \\\\\", \"tags\": [1, 2.5, true, null]}"; break;
+		case 1: text += std::to_string(i); break;
+		case 2: text += "\"s,]" + std::to_string(i) + "\""; break;
+		default: text += "[[], {}, [\"]\"], {\"x\": {\"y\": \"multi\nline\"}}]"; break;
+		}
+	}
+
+	return text + "]";
+}
+
+static void testParallel()
+{
+	const std::string text = makeRecords(40000);
+
+	for (unsigned int flags : { PJ_PARSE_DEFAULT, PJ_PARSE_ARENA, PJ_PARSE_INTERN_KEYS, PJ_PARSE_LAZY })
+	{
+		// lazy documents copy unmodified text when compact, but the parallel result is a new
+		// array, so the pretty output is compared
+		pj_Array* serial = pj_parseArrayEx(text.c_str(), flags);
+		const std::string expected = arrayString(serial, true);
+
+		for (unsigned int threads : { 1u, 2u, 4u })
+		{
+			pj_Array* parallel = pj_parseArrayParallel(text.data(), text.size(), flags, threads);
+			CHECK(pj_getArraySize(parallel) == 40000);
+			CHECK(arrayString(parallel, true) == expected);
+			pj_deleteArray(parallel);
+		}
+
+		// large arrays and objects are split up when serializing
+		pj_Object* obj = pj_createObj();
+		for (int i = 0; i < 5000; i++) pj_objSetNum(obj, ("key" + std::to_string(i)).c_str(), i * 0.5);
+		pj_arrayAddObj(serial, obj);
+
+		for (bool isPretty : { false, true })
+		{
+			size_t length = 0;
+			char* str = pj_arrayToStringParallel(serial, isPretty, 3, &length);
+			CHECK(take(str, length) == arrayString(serial, isPretty));
+
+			str = pj_objToStringParallel(obj, isPretty, 3, &length);
+			CHECK(take(str, length) == objString(obj, isPretty));
+
+			FILE* file = tmpfile();
+			CHECK(pj_arrayToFdParallel(serial, isPretty, 3, fileno(file)));
+			CHECK(readBack(file) == arrayString(serial, isPretty));
+
+			file = tmpfile();
+			CHECK(pj_objToFdParallel(obj, isPretty, 3, fileno(file)));
+			CHECK(readBack(file) == objString(obj, isPretty));
+		}
+
+		pj_deleteArray(serial);
+	}
+
+	// the element that fails is reported, the elements before it are kept
+	std::string broken = text;
+	broken.replace(broken.find("{\"id\": ", broken.size() / 2), 7, "{\"id\" ");
+
+	pj_Array* parallel = pj_parseArrayParallel(broken.data(), broken.size(), PJ_PARSE_DEFAULT, 3);
+	const char* error = pj_popError();
+	CHECK(error && strstr(error, "CHUNK LINENO"));
+	CHECK(pj_getArraySize(parallel) < 40000);
+	pj_deleteArray(parallel);
+	clearErrors();
+
+	// 1 KB records, the comma after the 257th is the first past the chunk size and the last
+	// before the closing bracket, so it is where the array is cut. it is still an error
+	std::string trailing = "[";
+	for (int i = 0; i < 257; i++)
+	{
+		std::string record = "{\"id\": " + std::to_string(i) + ", \"pad\": \"";
+		record += std::string(1024 - record.size() - 3, 'x') + "\"},";
+		trailing += record;
+	}
+	trailing += "]";
+
+	pj_Array* rejected = pj_parseArrayParallel(trailing.data(), trailing.size(), PJ_PARSE_DEFAULT, 2);
+	CHECK(pj_popError() != nullptr);
+	pj_deleteArray(rejected);
+	clearErrors();
+
+	CHECK(pj_popError() == nullptr);
+}
+
+int main()
+{
+	testArrays();
+	testArena();
+	testInSitu();
+	testScanning();
+	testEngines();
+	testMalformed();
+	testNumbers();
+	testBuilder();
+	testSinks();
+	testSax();
+	testFiles();
+	testLengthBounded();
+	testObjects();
+	testInterning();
+	testPaths();
+	testLazy();
+	testKeepSource();
+	testThreadErrors();
+	testNdjson();
+	testParallel();
+
+	if (failures) std::cerr << failures << " checks failed" << std::endl;
+	return failures ? 1 : 0;
+}
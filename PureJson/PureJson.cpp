@@ -0,0 +1,2 @@
+#define PURE_JSON_IMPLEMENTATION
+#include "PureJson.h"
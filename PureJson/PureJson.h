@@ -26,8 +26,12 @@ misrepresented as being the original software.
 
 #if defined(__cplusplus)
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #else
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 #endif
 
 #if defined(__cplusplus)
@@ -44,6 +48,14 @@ typedef int pj_boolean;
 
 typedef struct pj_Object pj_Object;
 typedef struct pj_Array pj_Array;
+typedef struct pj_Builder pj_Builder;
+typedef struct pj_SaxParser pj_SaxParser;
+typedef struct pj_Path pj_Path;
+typedef struct pj_Extractor pj_Extractor;
+
+// receives serialized output chunk by chunk, returns how many bytes it consumed.
+// anything short of length aborts the write
+typedef size_t(*pj_WriteCallback)(void* userData, const char* data, size_t length);
 
 #if defined(__cplusplus)
 namespace pj
@@ -77,9 +89,43 @@ typedef enum
 	PJ_VALUE_BOOL,
 	PJ_VALUE_OBJ,
 	PJ_VALUE_ARRAY,
-	PJ_VALUE_NULL
+	PJ_VALUE_NULL,
+	// integers that fit in 64 bits are kept exact. Number getters convert between the
+	// two representations and type checks treat them as the same type
+	PJ_VALUE_INT64
 } pj_ValueType;
 
+typedef enum
+{
+	PJ_PARSE_DEFAULT = 0,
+	// allocate every node, key and string of the document from a few large blocks.
+	// deleting the root releases the whole document at once, deleting any other node is a no-op
+	PJ_PARSE_ARENA = 1 << 0,
+	// share one copy of each distinct key between all objects of the document, which pays
+	// off for arrays of records with the same keys. implies PJ_PARSE_ARENA
+	PJ_PARSE_INTERN_KEYS = 1 << 1,
+	// only parse the members of the root, nested objects and arrays are parsed one level at
+	// a time on first access through a getter. They are not validated before that, errors
+	// inside them surface on access. Unaccessed subtrees are serialized as they appeared in
+	// the input unless pretty printing. The input is copied, so it need not outlive the
+	// document. Getters may modify the document, so it must not be read from several threads.
+	// implies PJ_PARSE_ARENA and the recursive engine
+	PJ_PARSE_LAZY = 1 << 2,
+	// keep a copy of the input, so objects and arrays that were not modified through
+	// pj_objSet* or pj_arrayAdd* since parsing, not even below them, are serialized by
+	// copying their input text when not pretty printing. implies PJ_PARSE_ARENA, and is
+	// implied by PJ_PARSE_LAZY
+	PJ_PARSE_KEEP_SOURCE = 1 << 3
+} pj_ParseFlags;
+
+typedef enum
+{
+	// recursive descent over the tokenizer
+	PJ_ENGINE_RECURSIVE,
+	// one SIMD pass indexes every structural character, a second one walks that index
+	PJ_ENGINE_STRUCTURAL_INDEX
+} pj_ParseEngine;
+
 /* Object Create/Delete */
 EXTERN_C pj_Object* pj_createObj();
 EXTERN_C void pj_deleteObj(pj_Object* json);
@@ -88,19 +134,192 @@ EXTERN_C void pj_deleteObj(pj_Object* json);
 EXTERN_C pj_Array* pj_createArray();
 EXTERN_C void pj_deleteArray(pj_Array* array);
 
+/* Array Capacity */
+EXTERN_C void pj_arrayReserve(pj_Array* array, size_t capacity);
+EXTERN_C void pj_arrayShrinkToFit(pj_Array* array);
+EXTERN_C size_t pj_getArrayCapacity(pj_Array* array);
+
 EXTERN_C void pj_deleteString(char* jsonString);
 
 /* Object/Array Parsers */
 EXTERN_C pj_Object* pj_parseObj(const char* raw);
 EXTERN_C pj_Array* pj_parseArray(const char* raw);
+EXTERN_C pj_Object* pj_parseObjEx(const char* raw, unsigned int flags);
+EXTERN_C pj_Array* pj_parseArrayEx(const char* raw, unsigned int flags);
+
+/* In-Situ Parsers
+ * Strings and keys of the document point into raw, which is decoded in place and
+ * must outlive the document. The document is arena backed (see PJ_PARSE_ARENA) */
+EXTERN_C pj_Object* pj_parseObjInSitu(char* raw);
+EXTERN_C pj_Array* pj_parseArrayInSitu(char* raw);
+
+/* Length-Bounded Parsers
+ * Parse exactly length bytes of raw, which needs no terminator. raw may be a slice of a
+ * larger receive or ring buffer. The result only depends on those bytes, but the SIMD
+ * scanners load whole aligned 16 or 32 byte blocks, so they may read the bytes around the
+ * slice that share a block with its first or last byte, never across a page. Nothing may
+ * write to those bytes while the slice is parsed */
+EXTERN_C pj_Object* pj_parseObjN(const char* raw, size_t length);
+EXTERN_C pj_Array* pj_parseArrayN(const char* raw, size_t length);
+
+/* File Parsers
+ * Map the file and parse it in place instead of reading it into a buffer first. Strings and
+ * keys point into the mapping, which is released with the document. Pages are copy on
+ * write, the file itself is never modified. The document is arena backed (see PJ_PARSE_ARENA) */
+EXTERN_C pj_Object* pj_parseObjFile(const char* fileName);
+EXTERN_C pj_Array* pj_parseArrayFile(const char* fileName);
+
+/* Parse Engine
+ * Selects the engine behind every parser above, for all threads. Both engines build the
+ * same documents, PJ_ENGINE_RECURSIVE is the default */
+EXTERN_C void pj_setParseEngine(pj_ParseEngine engine);
+EXTERN_C pj_ParseEngine pj_getParseEngine();
 
 EXTERN_C char* pj_arrayToString(pj_Array* array, pj_boolean isPretty);
+EXTERN_C char* pj_arrayToStringLen(pj_Array* array, pj_boolean isPretty, size_t* outLength);
 EXTERN_C pj_boolean pj_arrayToFile(pj_Array* array, pj_boolean isPretty, const char* fileName);
 EXTERN_C char* pj_objToString(pj_Object* obj, pj_boolean isPretty);
+EXTERN_C char* pj_objToStringLen(pj_Object* obj, pj_boolean isPretty, size_t* outLength);
 EXTERN_C pj_boolean pj_objToFile(pj_Object* obj, pj_boolean isPretty, const char* fileName);
 
+/* Streaming Output
+ * Serializes through a fixed size buffer that is flushed to the sink whenever it fills up,
+ * so the whole document never exists as a string. fd variants write with write(2) */
+EXTERN_C pj_boolean pj_arrayToStream(pj_Array* array, pj_boolean isPretty, FILE* file);
+EXTERN_C pj_boolean pj_arrayToFd(pj_Array* array, pj_boolean isPretty, int fd);
+EXTERN_C pj_boolean pj_arrayToCallback(pj_Array* array, pj_boolean isPretty, pj_WriteCallback callback, void* userData);
+EXTERN_C pj_boolean pj_objToStream(pj_Object* obj, pj_boolean isPretty, FILE* file);
+EXTERN_C pj_boolean pj_objToFd(pj_Object* obj, pj_boolean isPretty, int fd);
+EXTERN_C pj_boolean pj_objToCallback(pj_Object* obj, pj_boolean isPretty, pj_WriteCallback callback, void* userData);
+
+/* Builder
+ * Pushes JSON straight to a sink without building a document. Inside an object every
+ * value is preceded by pj_builderKey. pj_finishBuilder flushes and deletes the builder,
+ * it returns false if a write failed or the calls did not form exactly one complete value */
+EXTERN_C pj_Builder* pj_createBuilder(pj_boolean isPretty, pj_WriteCallback callback, void* userData);
+EXTERN_C pj_Builder* pj_createStreamBuilder(pj_boolean isPretty, FILE* file);
+EXTERN_C pj_Builder* pj_createFdBuilder(pj_boolean isPretty, int fd);
+EXTERN_C pj_boolean pj_finishBuilder(pj_Builder* builder);
+
+EXTERN_C void pj_builderBeginObject(pj_Builder* builder);
+EXTERN_C void pj_builderEndObject(pj_Builder* builder);
+EXTERN_C void pj_builderBeginArray(pj_Builder* builder);
+EXTERN_C void pj_builderEndArray(pj_Builder* builder);
+EXTERN_C void pj_builderKey(pj_Builder* builder, const char* key);
+EXTERN_C void pj_builderNum(pj_Builder* builder, double num);
+EXTERN_C void pj_builderInt64(pj_Builder* builder, int64_t num);
+EXTERN_C void pj_builderBool(pj_Builder* builder, pj_boolean boolean);
+EXTERN_C void pj_builderString(pj_Builder* builder, const char* str);
+EXTERN_C void pj_builderNull(pj_Builder* builder);
+EXTERN_C void pj_builderObj(pj_Builder* builder, pj_Object* obj);
+EXTERN_C void pj_builderArray(pj_Builder* builder, pj_Array* array);
+
+/* SAX Parser
+ * Resumable parser for input that arrives in pieces, from sockets, pipes or file reads.
+ * Chunks may be cut anywhere, values are reported as soon as they are complete and only
+ * the token cut off by the end of a chunk is kept around. Strings and keys are decoded
+ * and only valid during the callback. Any callback may be NULL, integers that fit in
+ * 64 bits go to int64 if it is set and to number otherwise */
+typedef struct
+{
+	void(*startObject)(void* userData);
+	void(*endObject)(void* userData);
+	void(*startArray)(void* userData);
+	void(*endArray)(void* userData);
+	void(*key)(void* userData, const char* key, size_t length);
+	void(*string)(void* userData, const char* str, size_t length);
+	void(*number)(void* userData, double num);
+	void(*int64)(void* userData, int64_t num);
+	void(*boolean)(void* userData, pj_boolean boolean);
+	void(*null)(void* userData);
+} pj_SaxCallbacks;
+
+EXTERN_C pj_SaxParser* pj_createSaxParser(const pj_SaxCallbacks* callbacks, void* userData);
+EXTERN_C void pj_deleteSaxParser(pj_SaxParser* parser);
+// returns false once the input stops being valid JSON, later chunks are ignored
+EXTERN_C pj_boolean pj_saxParserFeed(pj_SaxParser* parser, const char* data, size_t length);
+// marks the end of input, returns true if it held exactly one complete value
+EXTERN_C pj_boolean pj_saxParserFinish(pj_SaxParser* parser);
+
+/* NDJSON
+ * Parses newline delimited JSON, one object or array per line, on threadCount threads (0
+ * for one per core). Newlines inside strings do not end a record and blank lines are
+ * skipped. Each record becomes its own document, parsed with flags. Records are handed to
+ * the callback on the calling thread in input order, with index counting records rather
+ * than lines. A record that fails to parse comes with obj and array both NULL and its
+ * errors are raised on the calling thread. The callback owns the records. All three return
+ * the number of records */
+typedef void(*pj_RecordCallback)(void* userData, size_t index, pj_Object* obj, pj_Array* array);
+
+EXTERN_C size_t pj_parseNdjson(const char* data, size_t length, unsigned int flags, unsigned int threadCount, pj_RecordCallback callback, void* userData);
+EXTERN_C size_t pj_parseNdjsonFile(const char* fileName, unsigned int flags, unsigned int threadCount, pj_RecordCallback callback, void* userData);
+// collects the records into a new array, failed records become nulls
+EXTERN_C pj_Array* pj_parseNdjsonArray(const char* data, size_t length, unsigned int flags, unsigned int threadCount, size_t* outCount);
+
+/* Parallel Arrays
+ * Parses an array of records on threadCount threads (0 for one per core), taking the same
+ * flags as pj_parseArrayEx. A quick scan cuts the top level elements into chunks that are
+ * parsed at the same time and joined into the returned array, arrays too small to split are
+ * parsed as usual. Errors give the line their chunk starts on as CHUNK LINENO, their own
+ * LINENO counts from there. On errors the array holds the elements up to the chunk that failed */
+EXTERN_C pj_Array* pj_parseArrayParallel(const char* raw, size_t length, unsigned int flags, unsigned int threadCount);
+EXTERN_C pj_Array* pj_parseArrayFileParallel(const char* fileName, unsigned int flags, unsigned int threadCount);
+
+/* Parallel Output
+ * Serializes like pj_arrayToStringLen and pj_arrayToFd, byte for byte, with the members of
+ * large arrays and objects formatted on threadCount threads (0 for one per core). The Fd
+ * variants hand all pieces to the kernel with gathered writes. PJ_PARSE_LAZY documents are
+ * pretty printed on the calling thread, as that parses them */
+EXTERN_C char* pj_arrayToStringParallel(pj_Array* array, pj_boolean isPretty, unsigned int threadCount, size_t* outLength);
+EXTERN_C char* pj_objToStringParallel(pj_Object* obj, pj_boolean isPretty, unsigned int threadCount, size_t* outLength);
+EXTERN_C pj_boolean pj_arrayToFdParallel(pj_Array* array, pj_boolean isPretty, unsigned int threadCount, int fd);
+EXTERN_C pj_boolean pj_objToFdParallel(pj_Object* obj, pj_boolean isPretty, unsigned int threadCount, int fd);
+
+/* Compiled Paths
+ * A path is split and hashed once and can then be looked up any number of times without
+ * allocating. Paths are either dotted ("user.tags.0") or JSON Pointers ("/user/tags/0"),
+ * numeric segments also index into arrays. Missing members yield the same fail values as
+ * the getters below */
+EXTERN_C pj_Path* pj_compilePath(const char* path);
+EXTERN_C void pj_deletePath(pj_Path* path);
+
+EXTERN_C double pj_objGetNumAt(pj_Object* json, const pj_Path* path);
+EXTERN_C int64_t pj_objGetInt64At(pj_Object* json, const pj_Path* path);
+EXTERN_C pj_boolean pj_objGetBoolAt(pj_Object* json, const pj_Path* path);
+EXTERN_C const char* pj_objGetStringAt(pj_Object* json, const pj_Path* path);
+EXTERN_C pj_Array* pj_objGetArrayAt(pj_Object* json, const pj_Path* path);
+EXTERN_C pj_Object* pj_objGetObjAt(pj_Object* json, const pj_Path* path);
+
+EXTERN_C double pj_arrayGetNumAt(pj_Array* array, const pj_Path* path);
+EXTERN_C int64_t pj_arrayGetInt64At(pj_Array* array, const pj_Path* path);
+EXTERN_C pj_boolean pj_arrayGetBoolAt(pj_Array* array, const pj_Path* path);
+EXTERN_C const char* pj_arrayGetStringAt(pj_Array* array, const pj_Path* path);
+EXTERN_C pj_Array* pj_arrayGetArrayAt(pj_Array* array, const pj_Path* path);
+EXTERN_C pj_Object* pj_arrayGetObjAt(pj_Array* array, const pj_Path* path);
+
+/* Batch Extraction
+ * An extractor fills many fields of a caller struct in one call, walking the paths they
+ * have in common only once. Each field is written at its offset into the output as a
+ * double, int64_t, pj_boolean, const char*, pj_Array* or pj_Object* depending on its
+ * type, PJ_VALUE_NULL fields get a pj_boolean telling whether the value is null. Fields
+ * that are missing or of another type get the usual fail values */
+typedef struct
+{
+	const char* path;
+	pj_ValueType type;
+	size_t offset;
+} pj_Field;
+
+EXTERN_C pj_Extractor* pj_compileExtractor(const pj_Field* fields, size_t count);
+EXTERN_C void pj_deleteExtractor(pj_Extractor* extractor);
+
+// both return how many fields were found with the expected type
+EXTERN_C size_t pj_objExtract(pj_Object* json, const pj_Extractor* extractor, void* out);
+EXTERN_C size_t pj_arrayExtract(pj_Array* array, const pj_Extractor* extractor, void* out);
+
 /* Object Get */
 EXTERN_C double pj_objGetNum(pj_Object* json, const char* propName);
+EXTERN_C int64_t pj_objGetInt64(pj_Object* json, const char* propName);
 EXTERN_C pj_boolean pj_objGetBool(pj_Object* json, const char* propName);
 EXTERN_C const char* pj_objGetString(pj_Object* json, const char* propName);
 EXTERN_C pj_Array* pj_objGetArray(pj_Object* json, const char* propName);
@@ -108,6 +327,7 @@ EXTERN_C pj_Object* pj_objGetObj(pj_Object* json, const char* propName);
 
 /* Array Get */
 EXTERN_C double pj_arrayGetNum(pj_Array* array, size_t index);
+EXTERN_C int64_t pj_arrayGetInt64(pj_Array* array, size_t index);
 EXTERN_C pj_boolean pj_arrayGetBool(pj_Array* array, size_t index);
 EXTERN_C const char* pj_arrayGetString(pj_Array* array, size_t index);
 EXTERN_C pj_Array* pj_arrayGetArray(pj_Array* array, size_t index);
@@ -115,6 +335,7 @@ EXTERN_C pj_Object* pj_arrayGetObj(pj_Array* array, size_t index);
 
 /* Array Add */
 EXTERN_C void pj_arrayAddNum(pj_Array* array, double num);
+EXTERN_C void pj_arrayAddInt64(pj_Array* array, int64_t num);
 EXTERN_C void pj_arrayAddBool(pj_Array* array, pj_boolean boolean);
 EXTERN_C void pj_arrayAddString(pj_Array* array, const char* str);
 EXTERN_C void pj_arrayAddArray(pj_Array* array, pj_Array* other);
@@ -123,6 +344,7 @@ EXTERN_C void pj_arrayAddNull(pj_Array* array);
 
 /* Object Set */
 EXTERN_C void pj_objSetNum(pj_Object* obj, const char* propName, double num);
+EXTERN_C void pj_objSetInt64(pj_Object* obj, const char* propName, int64_t num);
 EXTERN_C void pj_objSetBool(pj_Object* obj, const char* propName, pj_boolean boolean);
 EXTERN_C void pj_objSetString(pj_Object* obj, const char* propName, const char* str);
 EXTERN_C void pj_objSetArray(pj_Object* obj, const char* propName, pj_Array* array);
@@ -139,6 +361,8 @@ EXTERN_C pj_boolean pj_isObjPropOfType(pj_Object* obj, const char* propName, pj_
 EXTERN_C void pj_objForEachKey(pj_Object* obj, void(*callback)(pj_Object*, const char*));
 EXTERN_C size_t pj_getArraySize(pj_Array* array);
 
+// errors are kept per thread, this returns the last one raised on the calling thread or
+// NULL. the string stays valid until the next error on that thread
 EXTERN_C const char* pj_popError();
 
 #if defined(PURE_JSON_IMPLEMENTATION)
@@ -151,23 +375,49 @@ EXTERN_C const char* pj_popError();
 #pragma warning(disable : 4996)
 #endif
 
-#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <new>
 #include <cctype>
+#include <cstdint>
+#include <clocale>
 #include <cassert>
 #include <iostream>
 #include <string>
 #include <cstring>
-#include <string>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+
+#if defined (_WIN32) || defined(_WIN64)
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
 
 static constexpr size_t MAX_ERRORS = 10;
-static struct Errors {
+// every thread has its own stack, so documents can be parsed and used on many threads at once
+static thread_local struct Errors {
 	// end of stack is reserved for null string
 	std::string stack[MAX_ERRORS + 1] = {};
 	size_t count = 0;
+	// every error ever pushed, tells whether anything failed in between two points
+	size_t pushed = 0;
 
 	void push(const std::string& error)
 	{
 		stack[count] = error;
+		pushed++;
 
 		count++;
 		if (count >= MAX_ERRORS)
@@ -179,12 +429,9 @@ static struct Errors {
 
 	const std::string& pop()
 	{
+		if (count == 0) return stack[MAX_ERRORS];
+
 		count--;
-		if (count < 0)
-		{
-			count = 0;
-			return stack[MAX_ERRORS];
-		}
 		return stack[count];
 	}
 
@@ -194,52 +441,133 @@ static struct Errors {
 // TODO: Implement Error Handling (preferably don't want to crash if json is invalid or
 // user attempts to get value from property that does not exist.
 
-void snipDblQuotes(const char* str, const char *& begin, const char *& end)
+static bool parseHex4(const char* str, uint32_t& code)
 {
-	begin = ++str;
-	end = str;
-
-	while (*end != '\"')
+	code = 0;
+	for (int i = 0; i < 4; i++)
 	{
-		if (*end == NULL)
-		{
-			using namespace std::string_literals;
-			errors.push("PARSER :: Could not find end of parsed string: "s + str);
-			// TODO: ERROR
-			end--;
-			break;
-		}
+		const char c = str[i];
+		code <<= 4;
 
-		end++;
+		if (c >= '0' && c <= '9') code |= c - '0';
+		else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+		else return false;
 	}
+
+	return true;
 }
 
-std::string parseString(const char * str)
+static char* encodeUtf8(char* out, uint32_t code)
 {
-	const char* begin;
-	const char* end;
-
-	snipDblQuotes(str, begin, end);
+	if (code < 0x80)
+	{
+		*out++ = (char)code;
+	}
+	else if (code < 0x800)
+	{
+		*out++ = (char)(0xC0 | (code >> 6));
+		*out++ = (char)(0x80 | (code & 0x3F));
+	}
+	else if (code < 0x10000)
+	{
+		*out++ = (char)(0xE0 | (code >> 12));
+		*out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (code & 0x3F));
+	}
+	else
+	{
+		*out++ = (char)(0xF0 | (code >> 18));
+		*out++ = (char)(0x80 | ((code >> 12) & 0x3F));
+		*out++ = (char)(0x80 | ((code >> 6) & 0x3F));
+		*out++ = (char)(0x80 | (code & 0x3F));
+	}
 
-	std::string result(begin, end);
-	return result;
+	return out;
 }
 
-char * parseCString(const char * str)
+// Decodes the escape sequences of the string body [begin, end) into out and returns the
+// decoded length. The result is never longer than the source, so out may alias begin.
+size_t decodeString(const char * begin, const char * end, char * out)
 {
-	const char* begin;
-	const char* end;
+	const char* escape = (const char*)memchr(begin, '\\', end - begin);
+	if (!escape)
+	{
+		if (out != begin) memcpy(out, begin, end - begin);
+		return end - begin;
+	}
+
+	char* const start = out;
+	if (out != begin) memmove(out, begin, escape - begin);
+	out += escape - begin;
+	begin = escape;
+
+	while (begin < end)
+	{
+		const char c = *begin++;
+		if (c != '\\' || begin == end)
+		{
+			*out++ = c;
+			continue;
+		}
 
-	snipDblQuotes(str, begin, end);
+		switch (*begin++)
+		{
+		case '"':  *out++ = '"';  break;
+		case '\\': *out++ = '\\'; break;
+		case '/':  *out++ = '/';  break;
+		case 'b':  *out++ = '\b'; break;
+		case 'f':  *out++ = '\f'; break;
+		case 'n':  *out++ = '\n'; break;
+		case 'r':  *out++ = '\r'; break;
+		case 't':  *out++ = '\t'; break;
+		case 'u':
+		{
+			uint32_t code;
+			if (end - begin < 4 || !parseHex4(begin, code))
+			{
+				errors.push("PARSER :: Invalid \\u escape in string");
+				*out++ = 'u';
+				break;
+			}
+			begin += 4;
 
-	const uint32_t size = end - begin;
-	char* result = new char[size + 1];
-	result[size] = NULL;
-	memcpy(result, begin, size);
+			if (code >= 0xD800 && code <= 0xDBFF)
+			{
+				// high surrogate, combine with the low half when it follows
+				uint32_t low;
+				if (end - begin >= 6 && begin[0] == '\\' && begin[1] == 'u' && parseHex4(begin + 2, low) && low >= 0xDC00 && low <= 0xDFFF)
+				{
+					code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+					begin += 6;
+				}
+				else
+				{
+					code = 0xFFFD;
+				}
+			}
+			else if (code >= 0xDC00 && code <= 0xDFFF)
+			{
+				code = 0xFFFD;
+			}
 
-	return result;
+			out = encodeUtf8(out, code);
+			break;
+		}
+		default:
+			errors.push("PARSER :: Unknown escape sequence in string");
+			*out++ = begin[-1];
+			break;
+		}
+	}
+
+	return out - start;
 }
 
+struct Arena;
+
+static char* allocString(Arena* arena, size_t length);
+
 
 bool cmpSubStr(const char * left, const char * right, size_t length)
 {
@@ -252,1077 +580,6056 @@ bool cmpSubStr(const char * left, const char * right, size_t length)
 }
 
 
-char * cpyStringDynamic(const char * str)
-{
-	const uint32_t stringLen = strlen(str);
-	char* result = new char[stringLen + 1]();
-	strcpy(result, str);
+static constexpr const char* INDENT = "    ";
+static constexpr size_t INDENT_LENGTH = 4;
 
-	return result;
-}
+static constexpr const char* DIGIT_PAIRS =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
 
-char * concatString(const char * left, const char * right)
+// writes the decimal digits of value so that they end right before end, two at a time,
+// and returns where they begin
+static char* formatDigits(uint64_t value, char* end)
 {
-	const size_t resultSize = strlen(left) + strlen(right);
-
-	char* result = new char[resultSize + 1]();
+	while (value >= 100)
+	{
+		end -= 2;
+		memcpy(end, DIGIT_PAIRS + (value % 100) * 2, 2);
+		value /= 100;
+	}
 
-	strcpy(result, left);
-	strcat(result, right);
+	if (value >= 10)
+	{
+		end -= 2;
+		memcpy(end, DIGIT_PAIRS + value * 2, 2);
+	}
+	else
+	{
+		*--end = (char)('0' + value);
+	}
 
-	return result;
+	return end;
 }
 
-void moveConcatString(char *& left, const char * right)
+static constexpr size_t MIN_ARRAY_CAPACITY = 4;
+static constexpr size_t ARRAY_LOOKAHEAD = 4096;
+static constexpr uint32_t MIN_OBJECT_CAPACITY = 4;
+// objects with more members than this get a hash index, smaller ones are scanned
+static constexpr uint32_t SMALL_OBJECT_SIZE = 16;
+static constexpr size_t ARENA_BLOCK_SIZE = 64 * 1024;
+static constexpr size_t STREAM_BUFFER_SIZE = 64 * 1024;
+// NDJSON records are split and delivered this many at a time, so memory stays bounded
+static constexpr size_t NDJSON_WINDOW = 16 * 1024;
+// records parsed by one task of the thread pool
+static constexpr size_t NDJSON_BATCH = 32;
+// the top level elements of pj_parseArrayParallel are parsed in chunks of about this many bytes
+static constexpr size_t ARRAY_CHUNK_SIZE = 256 * 1024;
+// arrays and objects with at least this many members are serialized in parallel, in chunks
+// of PARALLEL_CHUNK_MEMBERS
+static constexpr size_t PARALLEL_SPLIT_SIZE = 4096;
+static constexpr size_t PARALLEL_CHUNK_MEMBERS = 512;
+
+char * cpyStringDynamic(const char * str, Arena* arena)
 {
-	char* result = concatString(left, right);
-	delete[] left;
-	left = result;
+	const size_t stringLen = strlen(str);
+	char* result = allocString(arena, stringLen);
+	memcpy(result, str, stringLen + 1);
+
+	return result;
 }
 
-void moveConcatPropName(char *& left, const char * propName)
+// Growable output buffer used by the serializer. Every token is appended in place
+// and the buffer doubles when full, so serializing a document is amortized O(n).
+struct Writer
 {
-	constexpr const char* propEnd = "\": ";
-	constexpr size_t endSize = sizeof(propEnd - 1);
+	char* buffer = nullptr;
+	size_t size = 0;
+	size_t capacity = 0;
+
+	// streaming writers keep a fixed buffer and hand it to the sink whenever it fills up
+	pj_WriteCallback sink = nullptr;
+	void* sinkData = nullptr;
+	bool failed = false;
+
+	Writer() = default;
+
+	Writer(pj_WriteCallback sink, void* sinkData) :
+		buffer(new char[STREAM_BUFFER_SIZE]),
+		capacity(STREAM_BUFFER_SIZE),
+		sink(sink),
+		sinkData(sinkData)
+	{
+	}
 
-	const size_t nameSize = strlen(propName);
+	~Writer()
+	{
+		delete[] buffer;
+	}
 
-	char* result = new char[nameSize + endSize + 2]();
-	result[0] = '"';
-	strcpy(result + 1, propName);
-	strcpy(result + nameSize + 1, propEnd);
+	bool flush()
+	{
+		if (size && !failed && sink(sinkData, buffer, size) != size)
+			failed = true;
 
-	moveConcatString(left, result);
-}
+		size = 0;
+		return !failed;
+	}
 
-void moveConcatStringLiteral(char *& left, const char * stringVal)
-{
-	const size_t strSize = strlen(stringVal);
-	char* result = new char[strSize + 3]();
-	result[0] = '"';
+	void reserve(size_t extra)
+	{
+		const size_t required = size + extra + 1;
+		if (required <= capacity) return;
 
-	strncpy(result + 1, stringVal, strSize);
+		if (sink)
+		{
+			flush();
+			if (extra + 1 <= capacity) return;
+		}
 
-	result[strSize + 1] = '"';
+		size_t newCapacity = capacity ? capacity * 2 : 256;
+		while (newCapacity < required)
+			newCapacity *= 2;
 
-	moveConcatString(left, result);
-}
+		char* newBuffer = new char[newCapacity];
+		if (buffer) memcpy(newBuffer, buffer, size);
 
+		delete[] buffer;
+		buffer = newBuffer;
+		capacity = newCapacity;
+	}
 
-struct Token
-{
-	enum Type
+	void write(const char* str, size_t length)
 	{
-		UNKNOWN,
-		OPEN_BRACE,
-		CLOSE_BRACE,
-		COLON,
-		SQUARE_BRACKET_OPEN,
-		SQUARE_BRACKET_CLOSE,
-		COMMA,
-		STRING,
-		NUMBER,
-		BOOL,
-		JSON_NULL,
-		JSON_EOF
-	} type;
+		if (sink && size + length >= capacity)
+		{
+			flush();
 
-	int length;
-	const char* str;
-};
+			// too large to be worth copying into the buffer first
+			if (length >= capacity)
+			{
+				if (!failed && sink(sinkData, str, length) != length)
+					failed = true;
 
-struct Cursor
-{
-	const char* at;
-	size_t lineNo = 0;
-};
+				return;
+			}
+		}
 
-struct PeekToken
-{
-	Token token;
-	Cursor futureCursor;
-};
+		reserve(length);
+		memcpy(buffer + size, str, length);
+		size += length;
+	}
 
-void eatWhitespace(Cursor& cursor);
+	void write(const char* str)
+	{
+		write(str, strlen(str));
+	}
 
-Token getToken(Cursor& cursor);
+	// writes str as a quoted JSON string literal, escaping what the grammar requires
+	void writeString(const char* str, size_t length)
+	{
+		static constexpr const char* HEX = "0123456789abcdef";
 
-static constexpr Token unknownToken()
-{
-	Token t = {};
-	t.type = Token::UNKNOWN;
-	t.length = 0;
-	t.str = nullptr;
-	return t;
-}
+		if (!sink) reserve(length + 2);
+		put('"');
 
-static constexpr Token EOFToken()
-{
-	Token t = {};
-	t.type = Token::JSON_EOF;
-	t.length = 1;
-	t.str = 0;
-	return t;
-}
+		const char* run = str;
+		const char* end = str + length;
 
-static Token parseNumToken(const char* str);
-static Token parseStringToken(const char* str);
-static Token parseAlNumLiteralToken(const char* str);
+		for (const char* at = str; at < end; at++)
+		{
+			const unsigned char c = *at;
+			if (c >= 0x20 && c != '"' && c != '\\') continue;
 
-void eatWhitespace(Cursor& cursor)
-{
-	while (isspace(*cursor.at) && *cursor.at != NULL)
-	{
-		if (*cursor.at == '\n')
-			cursor.lineNo++;
+			write(run, at - run);
+			run = at + 1;
 
-		++cursor.at;
-	}
-}
+			char escape[6] = { '\\', 0 };
+			size_t escapeLength = 2;
 
-PeekToken peekToken(const Cursor& cursor)
-{
-	PeekToken pt = {};
-	pt.futureCursor = cursor;
+			switch (c)
+			{
+			case '"':  escape[1] = '"';  break;
+			case '\\': escape[1] = '\\'; break;
+			case '\b': escape[1] = 'b';  break;
+			case '\f': escape[1] = 'f';  break;
+			case '\n': escape[1] = 'n';  break;
+			case '\r': escape[1] = 'r';  break;
+			case '\t': escape[1] = 't';  break;
+			default:
+				escape[1] = 'u';
+				escape[2] = '0';
+				escape[3] = '0';
+				escape[4] = HEX[c >> 4];
+				escape[5] = HEX[c & 0xF];
+				escapeLength = 6;
+				break;
+			}
 
-	pt.token = getToken(pt.futureCursor);
-	return pt;
-}
+			write(escape, escapeLength);
+		}
 
-Token getToken(Cursor& cursor)
-{
-	Token t = {};
-	t.length = 1;
+		write(run, end - run);
+		put('"');
+	}
 
-	eatWhitespace(cursor);
+	void put(char c)
+	{
+		reserve(1);
+		buffer[size++] = c;
+	}
 
-	if (*cursor.at == NULL) return EOFToken();
+	void writeInt(int64_t value)
+	{
+		char digits[20];
+		char* const end = digits + sizeof(digits);
+		char* at = formatDigits(value < 0 ? 0 - (uint64_t)value : (uint64_t)value, end);
 
-	t.str = cursor.at;
+		if (value < 0) *--at = '-';
 
-	switch (*cursor.at)
+		write(at, end - at);
+	}
+
+	void indent(int depth)
 	{
-	case '{': t.type = Token::OPEN_BRACE;           break;
-	case '}': t.type = Token::CLOSE_BRACE;          break;
-	case ':': t.type = Token::COLON;			    break;
-	case ',': t.type = Token::COMMA;			    break;
-	case '[': t.type = Token::SQUARE_BRACKET_OPEN;  break;
-	case ']': t.type = Token::SQUARE_BRACKET_CLOSE; break;
-	case 'f':
-	case 't':
-	case 'n':
-		t = parseAlNumLiteralToken(cursor.at);
-		break;
-	case '"':
-		t = parseStringToken(cursor.at);
-		if (t.type == Token::UNKNOWN)
-		{
-			using namespace std::string_literals;
-			errors.push("Unknown token for assumed string literal. Check closing \"; LINENO: "s + std::to_string(cursor.lineNo));
-		}
+		for (int i = 0; i < depth; i++)
+			write(INDENT, INDENT_LENGTH);
+	}
 
-		break;
-	default:
-		if (isdigit(*cursor.at) || *cursor.at == '-')
-		{
-			t = parseNumToken(cursor.at);
-		}
-		else
-		{
-			return unknownToken();
-		}
+	// hands the NUL-terminated buffer to the caller, free with pj_deleteString
+	char* release(size_t* outLength)
+	{
+		reserve(0);
+		buffer[size] = 0;
+
+		if (outLength) *outLength = size;
+
+		char* result = buffer;
+		buffer = nullptr;
+		size = capacity = 0;
+		return result;
 	}
+};
 
-	cursor.at += t.length;
-	return t;
+// Scanning kernels used by the tokenizer. All of them take the end of the input and stop
+// there, or at a NUL, whichever comes first. On x86-64 the SSE2/AVX2 versions are picked once at runtime,
+// everything else (or PURE_JSON_NO_SIMD) gets the scalar loops.
+#if !defined(PURE_JSON_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define PJ_SIMD_X64
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define PJ_TARGET_AVX2
+#define PJ_NO_SANITIZE
+#else
+#define PJ_TARGET_AVX2 __attribute__((target("avx2")))
+// vector loads are aligned, so they never cross into an unmapped page, but they
+// may still touch bytes around the input that the sanitizer does not know about
+#define PJ_NO_SANITIZE __attribute__((no_sanitize_address))
+#endif
+#endif
+
+static inline bool isJsonSpace(char c)
+{
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static inline bool isStructural(char c)
+{
+	return c == '"' || c == ',' || c == '[' || c == ']' || c == '{' || c == '}' || c == 0;
 }
 
+// one 64 byte block of input, bit i describes block[i]
+struct BlockMasks
+{
+	uint64_t quote;
+	uint64_t backslash;
+	uint64_t whitespace;
+	// '{', '}', '[', ']', ':' and ','
+	uint64_t op;
+};
 
-Token parseNumToken(const char * str)
+struct ScanKernels
 {
-	Token t = {};
-	t.type = Token::NUMBER;
-	t.str = str;
+	// returns the first non whitespace character or end, counting the newlines skipped on the way
+	const char* (*skipWhitespace)(const char* at, const char* end, size_t& newlines);
+	// returns the first '"', '\\', NUL or end
+	const char* (*findQuoteOrEscape)(const char* at, const char* end);
+	// returns the first '"', ',', '[', ']', '{', '}', NUL or end
+	const char* (*findStructural)(const char* at, const char* end);
+	// classifies 64 bytes, all of which must be readable
+	void (*classifyBlock)(const char* block, BlockMasks& masks);
+};
 
-	while (isdigit(*str) || *str == '-' || *str == 'e' || *str == '.')
+#if !defined(PJ_SIMD_X64)
+
+static const char* skipWhitespaceScalar(const char* at, const char* end, size_t& newlines)
+{
+	while (at < end && isJsonSpace(*at))
 	{
-		str++;
-		t.length++;
+		if (*at == '\n') newlines++;
+		at++;
 	}
 
-	return t;
+	return at;
 }
 
-Token parseStringToken(const char * str)
+static const char* findQuoteOrEscapeScalar(const char* at, const char* end)
 {
-	Token t = {};
-	t.length = 1;
-	t.str = str;
-	++str;
+	while (at < end && *at != '"' && *at != '\\' && *at != 0)
+		at++;
+
+	return at;
+}
 
-	while (*str != '"')
+static const char* findStructuralScalar(const char* at, const char* end)
+{
+	while (at < end && !isStructural(*at))
+		at++;
+
+	return at;
+}
+
+static void classifyBlockScalar(const char* block, BlockMasks& masks)
+{
+	masks = {};
+
+	for (int i = 0; i < 64; i++)
 	{
-		t.length++;
-		str++;
+		const uint64_t bit = 1ull << i;
 
-		if (*str == NULL)
+		switch (block[i])
 		{
-			return unknownToken();
+		case '"':  masks.quote |= bit;      break;
+		case '\\': masks.backslash |= bit;  break;
+		case ' ':
+		case '\t':
+		case '\n':
+		case '\r': masks.whitespace |= bit; break;
+		case '{':
+		case '}':
+		case '[':
+		case ']':
+		case ':':
+		case ',':  masks.op |= bit;         break;
 		}
 	}
+}
 
-	t.length++;
-	t.type = Token::STRING;
-	return t;
+#endif
+
+#if defined(PJ_SIMD_X64)
+
+static inline uint32_t countTrailingZeros(uint32_t mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
 }
 
-Token parseAlNumLiteralToken(const char * str)
+static inline uint32_t popCount(uint32_t mask)
 {
-	constexpr const char* t = "true";
-	constexpr const char* f = "false";
-	constexpr const char* n = "null";
-
-	Token token = {};
-	token.str = str;
-
-	if (cmpSubStr(str, t, strlen(t)))
-	{
-		token.length = strlen(t);
-		token.type = Token::BOOL;
-	}
-	else if (cmpSubStr(str, f, strlen(f)))
-	{
-		token.length = strlen(f);
-		token.type = Token::BOOL;
-	}
-	else if (cmpSubStr(str, n, strlen(n)))
-	{
-		token.length = strlen(n);
-		token.type = Token::JSON_NULL;
-	}
-	else
-	{
-		token = unknownToken();
-	}
+	// plain bit trick, POPCNT is not part of the SSE2 baseline
+	mask = mask - ((mask >> 1) & 0x55555555);
+	mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+	return (((mask + (mask >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+}
 
+// Per block classifiers, bit i of the result describes block[i]. Blocks are always
+// loaded aligned and only when they hold at least one byte of input, so a load never
+// crosses into an unmapped page past the end.
 
-	return token;
+PJ_NO_SANITIZE static inline uint32_t whitespaceMask16(const char* block, uint32_t& lfMask)
+{
+	const __m128i chunk = _mm_load_si128((const __m128i*)block);
+	const __m128i isLf = _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'));
+	const __m128i isSpace = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+		_mm_or_si128(isLf, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+
+	lfMask = (uint32_t)_mm_movemask_epi8(isLf);
+	return (uint32_t)_mm_movemask_epi8(isSpace);
 }
 
+PJ_NO_SANITIZE static inline uint32_t quoteOrEscapeMask16(const char* block)
+{
+	const __m128i chunk = _mm_load_si128((const __m128i*)block);
+	const __m128i hit = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+		_mm_cmpeq_epi8(chunk, _mm_setzero_si128()));
 
+	return (uint32_t)_mm_movemask_epi8(hit);
+}
 
-static constexpr const char* INDENT = "    ";
+PJ_NO_SANITIZE static inline uint32_t structuralMask16(const char* block)
+{
+	const __m128i chunk = _mm_load_si128((const __m128i*)block);
+	// '{' and '}' are '[' and ']' with bit 0x20 set, so clearing it folds them together
+	const __m128i folded = _mm_and_si128(chunk, _mm_set1_epi8((char)0xDF));
+	const __m128i hit = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))),
+		_mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('[')), _mm_cmpeq_epi8(folded, _mm_set1_epi8(']'))),
+			_mm_cmpeq_epi8(chunk, _mm_setzero_si128())));
+
+	return (uint32_t)_mm_movemask_epi8(hit);
+}
 
-struct JsonVal
+PJ_TARGET_AVX2 PJ_NO_SANITIZE static inline uint32_t whitespaceMask32(const char* block, uint32_t& lfMask)
 {
-	pj_ValueType type;
+	const __m256i chunk = _mm256_load_si256((const __m256i*)block);
+	const __m256i isLf = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'));
+	const __m256i isSpace = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+		_mm256_or_si256(isLf, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'))));
+
+	lfMask = (uint32_t)_mm256_movemask_epi8(isLf);
+	return (uint32_t)_mm256_movemask_epi8(isSpace);
+}
 
-	union
-	{
-		double num;
-		bool boolean;
-		char* string;
-		pj_Array* array;
-		pj_Object* obj;
-	};
+PJ_TARGET_AVX2 PJ_NO_SANITIZE static inline uint32_t quoteOrEscapeMask32(const char* block)
+{
+	const __m256i chunk = _mm256_load_si256((const __m256i*)block);
+	const __m256i hit = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))),
+		_mm256_cmpeq_epi8(chunk, _mm256_setzero_si256()));
 
-	JsonVal() = default;
-	JsonVal(const JsonVal& other) = delete;
-	JsonVal operator=(JsonVal& other) = delete;
+	return (uint32_t)_mm256_movemask_epi8(hit);
+}
 
-	JsonVal& operator=(JsonVal&& other)
-	{
-		type = other.type;
-		if (this != &other)
-		{
-			free();
-			move(std::forward<JsonVal>(other));
-		}
+PJ_TARGET_AVX2 PJ_NO_SANITIZE static inline uint32_t structuralMask32(const char* block)
+{
+	const __m256i chunk = _mm256_load_si256((const __m256i*)block);
+	const __m256i folded = _mm256_and_si256(chunk, _mm256_set1_epi8((char)0xDF));
+	const __m256i hit = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(','))),
+		_mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('[')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8(']'))),
+			_mm256_cmpeq_epi8(chunk, _mm256_setzero_si256())));
+
+	return (uint32_t)_mm256_movemask_epi8(hit);
+}
 
-		return *this;
-	}
+// bytes from end on stop a scan just like a match, so a block holding the end of the
+// input is the last one loaded
+static inline uint32_t pastEndMask(const char* block, const char* end, ptrdiff_t width)
+{
+	const ptrdiff_t remaining = end - block;
+	return remaining < width ? ~0u << remaining : 0;
+}
 
-	JsonVal(JsonVal&& other) :
-		type(other.type)
-	{
-		move(std::forward<JsonVal>(other));
-	}
+// The scanners start with the aligned 16 byte block holding 'at' and mask off the bytes
+// in front of it. The AVX2 variants stay on 16 byte blocks until they reach 32 byte
+// alignment: most tokens end within the first block, where the wider load does not pay off.
 
-	~JsonVal()
-	{
-		free();
-	}
+PJ_NO_SANITIZE static const char* skipWhitespaceSSE2(const char* at, const char* end, size_t& newlines)
+{
+	if (at >= end) return at;
 
-private:
+	const uint32_t offset = (uintptr_t)at & 15;
+	const char* block = at - offset;
+	// bytes in front of 'at' count as whitespace but not as newlines
+	uint32_t before = (1u << offset) - 1;
 
-	void free()
+	for (;; block += 16, before = 0)
 	{
-		switch (type)
-		{
-		case PJ_VALUE_STRING:
-			delete[] string;
-			string = nullptr;
-			break;
-		case PJ_VALUE_ARRAY:
-			pj_deleteArray(array);
-			array = nullptr;
-			break;
-		case PJ_VALUE_OBJ:
-			pj_deleteObj(obj);
-			obj = nullptr;
-			break;
-		}
-	}
+		uint32_t lfMask;
+		const uint32_t stop = (~(whitespaceMask16(block, lfMask) | before) & 0xFFFF) | pastEndMask(block, end, 16);
+		lfMask &= ~before;
 
-	void move(JsonVal&& other)
-	{
-		switch (other.type)
+		if (stop)
 		{
-		case PJ_VALUE_NUMBER: num = other.num; break;
-		case PJ_VALUE_STRING:
-			string = other.string;
-			other.string = nullptr;
-			break;
-		case PJ_VALUE_BOOL: boolean = other.boolean; break;
-		case PJ_VALUE_OBJ:
-			obj = other.obj;
-			other.obj = nullptr;
-			break;
-		case PJ_VALUE_ARRAY:
-			array = other.array;
-			other.array = nullptr;
-			break;
+			const uint32_t index = countTrailingZeros(stop);
+			newlines += popCount(lfMask & ((1u << index) - 1));
+			return block + index;
 		}
+
+		newlines += popCount(lfMask);
+		if (block + 16 >= end) return end;
 	}
-};
+}
 
-struct JsonProp
+PJ_NO_SANITIZE static const char* findQuoteOrEscapeSSE2(const char* at, const char* end)
 {
-	std::string name;
+	if (at >= end) return at;
 
-	JsonVal val;
-};
-
-struct pj_Array
-{
-	JsonVal* items;
-	size_t size;
-	size_t capacity;
-};
+	const uint32_t offset = (uintptr_t)at & 15;
+	const char* block = at - offset;
+	uint32_t found = (quoteOrEscapeMask16(block) | pastEndMask(block, end, 16)) & (~0u << offset);
 
-struct pj_Object
-{
-	std::unordered_map<std::string, JsonProp> data;
-};
+	while (!found)
+	{
+		block += 16;
+		if (block >= end) return end;
+		found = quoteOrEscapeMask16(block) | pastEndMask(block, end, 16);
+	}
 
-static void parseJSONObject(Cursor& cursor, pj_Object* json);
-static void parseJSONArray(Cursor& cursor, pj_Array* array);
-static bool parseJSONValue(Cursor& cursor, Token& valueToken, JsonVal& val);
-static char* objectToString(pj_Object* obj, int depth, pj_boolean isPretty);
-static char* arrayToString(pj_Array* array, int depth, pj_boolean isPretty);
-static char* valueToString(JsonVal& val, int depth, pj_boolean isPretty);
-static pj_boolean writeToFile(const char* fileName, char* str);
+	return block + countTrailingZeros(found);
+}
 
-static void addArrayValue(pj_Array& array, struct JsonVal&& val);
+PJ_NO_SANITIZE static const char* findStructuralSSE2(const char* at, const char* end)
+{
+	if (at >= end) return at;
 
-static struct JsonProp* findProp(pj_Object& obj, const char* propName);
+	const uint32_t offset = (uintptr_t)at & 15;
+	const char* block = at - offset;
+	uint32_t found = (structuralMask16(block) | pastEndMask(block, end, 16)) & (~0u << offset);
 
-template <typename T, pj_ValueType valType>
-T getValueOfType(JsonVal& val, T failVal)
-{
-	if (val.type != valType) return failVal;
+	while (!found)
+	{
+		block += 16;
+		if (block >= end) return end;
+		found = structuralMask16(block) | pastEndMask(block, end, 16);
+	}
 
-	if constexpr (valType == PJ_VALUE_NUMBER)
-		return val.num;
-	else if constexpr (valType == PJ_VALUE_STRING)
-		return val.string;
-	else if constexpr (valType == PJ_VALUE_BOOL)
-		return val.boolean;
-	else if constexpr (valType == PJ_VALUE_OBJ)
-		return val.obj;
-	else if constexpr (valType == PJ_VALUE_ARRAY)
-		return val.array;
-	else if constexpr (valType == PJ_VALUE_NULL)
-		return failVal;
+	return block + countTrailingZeros(found);
 }
 
-template<typename T, pj_ValueType valType>
-T getObjectValue(pj_Object* json, const char* propName, T failVal = 0)
+PJ_TARGET_AVX2 PJ_NO_SANITIZE static const char* skipWhitespaceAVX2(const char* at, const char* end, size_t& newlines)
 {
-	std::string name{ propName };
-
-	{
-		static const std::string delim = ".";
-		if (name.find(".") != std::string::npos)
-		{
-			size_t pos = name.find(".");
-			std::string prop = name.substr(0, pos);
+	if (at >= end) return at;
 
-			JsonProp* jprop = findProp(*json, prop.c_str());
-			assert(jprop->val.type == PJ_VALUE_OBJ);
+	const uint32_t offset = (uintptr_t)at & 15;
+	const char* block = at - offset;
+	uint32_t before = (1u << offset) - 1;
 
-			pj_Object* obj = jprop->val.obj;
-			name.erase(0, pos + delim.length());
+	for (;; block += 16, before = 0)
+	{
+		uint32_t lfMask;
+		const uint32_t stop = (~(whitespaceMask16(block, lfMask) | before) & 0xFFFF) | pastEndMask(block, end, 16);
+		lfMask &= ~before;
 
-			return getObjectValue<T, valType>(obj, name.c_str(), failVal);
+		if (stop)
+		{
+			const uint32_t index = countTrailingZeros(stop);
+			newlines += popCount(lfMask & ((1u << index) - 1));
+			return block + index;
 		}
+
+		newlines += popCount(lfMask);
+		if (block + 16 >= end) return end;
+		if (((uintptr_t)block & 31) == 16) break;
 	}
 
-	if (JsonProp* prop = findProp(*json, name.c_str()))
+	for (block += 16;; block += 32)
 	{
-		if (prop->val.type == PJ_VALUE_NULL) return failVal;
+		uint32_t lfMask;
+		const uint32_t stop = ~whitespaceMask32(block, lfMask) | pastEndMask(block, end, 32);
 
-		assert(prop->val.type == valType);
+		if (stop)
+		{
+			const uint32_t index = countTrailingZeros(stop);
+			newlines += popCount(lfMask & ((1ull << index) - 1));
+			return block + index;
+		}
 
-		return getValueOfType<T, valType>(prop->val, failVal);
+		newlines += popCount(lfMask);
+		if (block + 32 >= end) return end;
 	}
-
-	return failVal;
 }
 
-template<typename T, pj_ValueType valType>
-T getArrayValue(pj_Array* array, size_t index, T failVal = 0)
+PJ_TARGET_AVX2 PJ_NO_SANITIZE static const char* findQuoteOrEscapeAVX2(const char* at, const char* end)
 {
-	assert(index >= 0 && index < array->size);
+	if (at >= end) return at;
 
-	JsonVal& val = array->items[index];
+	const uint32_t offset = (uintptr_t)at & 15;
+	const char* block = at - offset;
+	uint32_t found = (quoteOrEscapeMask16(block) | pastEndMask(block, end, 16)) & (~0u << offset);
 
-	if (val.type == PJ_VALUE_NULL) return failVal;
+	if (!found && ((uintptr_t)block & 31) == 0)
+	{
+		block += 16;
+		if (block >= end) return end;
+		found = quoteOrEscapeMask16(block) | pastEndMask(block, end, 16);
+	}
 
-	assert(val.type == valType);
+	if (found) return block + countTrailingZeros(found);
 
-	return getValueOfType<T, valType>(val, failVal);
+	for (block += 16;; block += 32)
+	{
+		if (block >= end) return end;
+		found = quoteOrEscapeMask32(block) | pastEndMask(block, end, 32);
+		if (found) return block + countTrailingZeros(found);
+	}
 }
 
-EXTERN_C pj_Object * pj_parseObj(const char * raw)
+PJ_TARGET_AVX2 PJ_NO_SANITIZE static const char* findStructuralAVX2(const char* at, const char* end)
 {
-	pj_Object* json = pj_createObj();
-	Cursor c = { raw };
+	if (at >= end) return at;
+
+	const uint32_t offset = (uintptr_t)at & 15;
+	const char* block = at - offset;
+	uint32_t found = (structuralMask16(block) | pastEndMask(block, end, 16)) & (~0u << offset);
 
-	if (getToken(c).type == Token::OPEN_BRACE)
+	if (!found && ((uintptr_t)block & 31) == 0)
 	{
-		parseJSONObject(c, json);
-		return json;
+		block += 16;
+		if (block >= end) return end;
+		found = structuralMask16(block) | pastEndMask(block, end, 16);
 	}
-	else
+
+	if (found) return block + countTrailingZeros(found);
+
+	for (block += 16;; block += 32)
 	{
-		pj_deleteObj(json);
-		return nullptr;
+		if (block >= end) return end;
+		found = structuralMask32(block) | pastEndMask(block, end, 32);
+		if (found) return block + countTrailingZeros(found);
 	}
 }
 
-EXTERN_C pj_Array * pj_parseArray(const char * raw)
+// Unlike the scanners above, block classification only ever sees whole blocks inside
+// the input, so these loads are unaligned.
+
+static void classifyBlockSSE2(const char* block, BlockMasks& masks)
 {
-	pj_Array* array = pj_createArray();
-	Cursor c = { raw };
+	masks = {};
 
-	if (getToken(c).type == Token::SQUARE_BRACKET_OPEN)
-	{
-		parseJSONArray(c, array);
-		return array;
-	}
-	else
+	for (int i = 0; i < 64; i += 16)
 	{
-		pj_deleteArray(array);
-		return nullptr;
+		const __m128i chunk = _mm_loadu_si128((const __m128i*)(block + i));
+		const __m128i folded = _mm_and_si128(chunk, _mm_set1_epi8((char)0xDF));
+		const __m128i op = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('[')), _mm_cmpeq_epi8(folded, _mm_set1_epi8(']'))),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))));
+		const __m128i space = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r'))));
+
+		masks.quote |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))) << i;
+		masks.backslash |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))) << i;
+		masks.whitespace |= (uint64_t)(uint32_t)_mm_movemask_epi8(space) << i;
+		masks.op |= (uint64_t)(uint32_t)_mm_movemask_epi8(op) << i;
 	}
-
 }
 
-EXTERN_C char * pj_arrayToString(pj_Array * array, pj_boolean isPretty)
+PJ_TARGET_AVX2 static void classifyBlockAVX2(const char* block, BlockMasks& masks)
 {
-	return arrayToString(array, 0, isPretty);
-}
+	masks = {};
 
-EXTERN_C pj_boolean pj_arrayToFile(pj_Array * array, pj_boolean isPretty, const char* fileName)
-{
-	pj::String stringified = pj_arrayToString(array, isPretty);
-	return writeToFile(fileName, stringified.handle);
+	for (int i = 0; i < 64; i += 32)
+	{
+		const __m256i chunk = _mm256_loadu_si256((const __m256i*)(block + i));
+		const __m256i folded = _mm256_and_si256(chunk, _mm256_set1_epi8((char)0xDF));
+		const __m256i op = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('[')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8(']'))),
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(','))));
+		const __m256i space = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))),
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r'))));
+
+		masks.quote |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))) << i;
+		masks.backslash |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))) << i;
+		masks.whitespace |= (uint64_t)(uint32_t)_mm256_movemask_epi8(space) << i;
+		masks.op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << i;
+	}
 }
 
-EXTERN_C char * pj_objToString(pj_Object* obj, pj_boolean isPretty)
+static bool cpuHasAVX2()
 {
-	return objectToString(obj, 0, isPretty);
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
 }
 
-EXTERN_C pj_boolean pj_objToFile(pj_Object* obj, pj_boolean isPretty, const char* fileName)
+#endif // PJ_SIMD_X64
+
+static ScanKernels selectScanKernels()
 {
-	pj::String stringified = pj_objToString(obj, isPretty);
-	return writeToFile(fileName, stringified.handle);
+#if defined(PJ_SIMD_X64)
+	if (cpuHasAVX2())
+		return { skipWhitespaceAVX2, findQuoteOrEscapeAVX2, findStructuralAVX2, classifyBlockAVX2 };
+
+	return { skipWhitespaceSSE2, findQuoteOrEscapeSSE2, findStructuralSSE2, classifyBlockSSE2 };
+#else
+	return { skipWhitespaceScalar, findQuoteOrEscapeScalar, findStructuralScalar, classifyBlockScalar };
+#endif
 }
 
-EXTERN_C pj_Object * pj_createObj()
+static const ScanKernels& scanKernels()
 {
-	return new pj_Object();
+	static const ScanKernels kernels = selectScanKernels();
+	return kernels;
 }
 
-EXTERN_C void pj_deleteObj(pj_Object* json)
+// Stage one of PJ_ENGINE_STRUCTURAL_INDEX. The input is classified 64 bytes at a time,
+// string bodies are masked out with a prefix xor over the unescaped quotes and what is
+// left is flattened into the offsets of every operator, opening quote and scalar start.
+
+static inline uint32_t lowestBitIndex(uint64_t mask)
 {
-	delete json;
+#if defined(_MSC_VER) && !defined(__clang__) && defined(PJ_SIMD_X64)
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return index;
+#elif defined(_MSC_VER) && !defined(__clang__)
+	uint32_t index = 0;
+	while (!(mask & 1)) { mask >>= 1; index++; }
+	return index;
+#else
+	return __builtin_ctzll(mask);
+#endif
 }
 
-EXTERN_C pj_Array * pj_createArray()
+// bit i becomes the parity of bits [0, i]
+static inline uint64_t prefixXor(uint64_t bits)
 {
-	pj_Array* array = new pj_Array();
-
-	array->capacity = 0;
-	array->size = 0;
-
-	return new pj_Array();
+	bits ^= bits << 1;
+	bits ^= bits << 2;
+	bits ^= bits << 4;
+	bits ^= bits << 8;
+	bits ^= bits << 16;
+	bits ^= bits << 32;
+	return bits;
 }
 
-EXTERN_C void pj_deleteArray(pj_Array * array)
+// Marks every character that follows an odd run of backslashes. Backslashes are rare
+// outside of escaped text, so walking them one by one beats a branchless carry trick.
+// carry is 1 when the block starts with a character escaped by the previous one.
+static inline uint64_t escapedMask(uint64_t backslash, uint64_t& carry)
 {
-	if (array)
+	uint64_t escaped = carry;
+	backslash &= ~carry;
+	carry = 0;
+
+	while (backslash)
 	{
-		delete[] array->items;
-		delete array;
+		const uint32_t index = lowestBitIndex(backslash);
+		if (index == 63)
+		{
+			carry = 1;
+			break;
+		}
+
+		// the escaped character can not start an escape itself
+		escaped |= 2ull << index;
+		backslash &= ~(3ull << index);
 	}
-}
 
-EXTERN_C void pj_deleteString(char * jsonString)
-{
-	delete[] jsonString;
+	return escaped;
 }
 
-EXTERN_C double pj_objGetNum(pj_Object * json, const char * propName)
+// A classified block once its strings are known. op and whitespace only keep the
+// characters outside of strings.
+struct BlockBits
 {
-	return getObjectValue<double, PJ_VALUE_NUMBER>(json, propName);
-}
+	// the block itself, or a copy padded with whitespace when it is the last one
+	const char* bytes;
+	uint64_t op;
+	uint64_t whitespace;
+	// unescaped quotes, opening and closing
+	uint64_t quote;
+	// set from an opening quote up to, but not including, its closing quote
+	uint64_t string;
+};
 
-EXTERN_C pj_boolean pj_objGetBool(pj_Object * json, const char * propName)
+// Classifies [at, end) 64 bytes at a time, carrying escapes and strings over from one block
+// to the next. visit(block, bits) gets where each block starts in the input and returns
+// false to stop early.
+template<typename Visit>
+static void scanBlocks(const char* at, const char* end, Visit&& visit)
 {
-	return getObjectValue<pj_boolean, PJ_VALUE_BOOL>(json, propName);
-}
+	const ScanKernels& kernels = scanKernels();
 
-EXTERN_C const char* pj_objGetString(pj_Object * json, const char * propName)
-{
-	return getObjectValue<const char*, PJ_VALUE_STRING>(json, propName);
-}
+	uint64_t inString = 0;
+	uint64_t escapeCarry = 0;
+	char tail[64];
 
-EXTERN_C pj_Array* pj_objGetArray(pj_Object * json, const char * propName)
-{
-	return getObjectValue<pj_Array*, PJ_VALUE_ARRAY>(json, propName);
-}
+	for (const char* block = at; block < end; block += 64)
+	{
+		BlockBits bits;
+		bits.bytes = block;
+		if (end - block < 64)
+		{
+			// pad the last block with whitespace, which is never structural
+			memset(tail, ' ', sizeof(tail));
+			memcpy(tail, block, end - block);
+			bits.bytes = tail;
+		}
 
-EXTERN_C pj_Object* pj_objGetObj(pj_Object * json, const char * propName)
-{
-	return getObjectValue<pj_Object*, PJ_VALUE_OBJ>(json, propName);
-}
+		BlockMasks masks;
+		kernels.classifyBlock(bits.bytes, masks);
 
-EXTERN_C double pj_arrayGetNum(pj_Array * array, size_t index)
-{
-	return getArrayValue<double, PJ_VALUE_NUMBER>(array, index);
-}
+		bits.quote = masks.quote & ~escapedMask(masks.backslash, escapeCarry);
+		bits.string = prefixXor(bits.quote) ^ inString;
+		inString = (uint64_t)((int64_t)bits.string >> 63);
 
-EXTERN_C pj_boolean pj_arrayGetBool(pj_Array * array, size_t index)
-{
-	return getArrayValue<pj_boolean, PJ_VALUE_BOOL>(array, index);
-}
+		bits.op = masks.op & ~bits.string;
+		bits.whitespace = masks.whitespace & ~bits.string;
 
-EXTERN_C const char* pj_arrayGetString(pj_Array * array, size_t index)
-{
-	return getArrayValue<const char*, PJ_VALUE_STRING>(array, index);
+		if (!visit(block, bits)) return;
+	}
 }
 
-EXTERN_C pj_Array * pj_arrayGetArray(pj_Array * array, size_t index)
+static void buildStructuralIndex(const char* raw, size_t length, std::vector<uint32_t>& index)
+{
+	uint64_t inScalar = 0;
+
+	index.reserve(length / 8 + 16);
+
+	scanBlocks(raw, raw + length, [&](const char* block, const BlockBits& bits)
+	{
+		const size_t offset = block - raw;
+
+		// numbers and literals, only their first character is indexed
+		const uint64_t scalar = ~(bits.op | bits.whitespace | bits.quote | bits.string);
+		const uint64_t scalarStart = scalar & ~((scalar << 1) | inScalar);
+		inScalar = scalar >> 63;
+
+		uint64_t structurals = bits.op | (bits.quote & bits.string) | scalarStart;
+		while (structurals)
+		{
+			index.push_back((uint32_t)(offset + lowestBitIndex(structurals)));
+			structurals &= structurals - 1;
+		}
+
+		return true;
+	});
+}
+
+struct Token
+{
+	enum Type
+	{
+		UNKNOWN,
+		OPEN_BRACE,
+		CLOSE_BRACE,
+		COLON,
+		SQUARE_BRACKET_OPEN,
+		SQUARE_BRACKET_CLOSE,
+		COMMA,
+		STRING,
+		NUMBER,
+		BOOL,
+		JSON_NULL,
+		JSON_EOF
+	} type;
+
+	int length;
+	const char* str;
+
+	// string tokens only, set when the body contains a backslash
+	bool hasEscapes;
+};
+
+struct Cursor
+{
+	const char* at;
+	// one past the last byte of input, nothing from here on is read
+	const char* end;
+	size_t lineNo = 0;
+};
+
+// stage two of PJ_ENGINE_STRUCTURAL_INDEX reads tokens at the offsets found by stage one
+struct IndexCursor
+{
+	const char* raw;
+	const char* rawEnd;
+	const uint32_t* at;
+	const uint32_t* end;
+};
+
+struct PeekToken
+{
+	Token token;
+	Cursor futureCursor;
+};
+
+void eatWhitespace(Cursor& cursor);
+
+Token getToken(Cursor& cursor);
+
+static constexpr Token unknownToken()
+{
+	Token t = {};
+	t.type = Token::UNKNOWN;
+	t.length = 0;
+	t.str = nullptr;
+	return t;
+}
+
+static constexpr Token EOFToken()
+{
+	Token t = {};
+	t.type = Token::JSON_EOF;
+	t.length = 1;
+	t.str = 0;
+	return t;
+}
+
+static inline bool isDigit(char c)
+{
+	return (unsigned char)(c - '0') < 10;
+}
+
+// the character at 'at', or NUL past the end of the input
+static inline char charAt(const char* at, const char* end)
+{
+	return at < end ? *at : 0;
+}
+
+static Token parseNumToken(const char* str, const char* end);
+static Token parseStringToken(const char* str, const char* end);
+static Token parseAlNumLiteralToken(const char* str, const char* end);
+
+void eatWhitespace(Cursor& cursor)
+{
+	// compact documents rarely have more than the single space after a colon,
+	// only hand longer runs (indentation) to the vector kernel
+	if (!isJsonSpace(charAt(cursor.at, cursor.end))) return;
+
+	if (!isJsonSpace(charAt(cursor.at + 1, cursor.end)))
+	{
+		if (cursor.at[0] == '\n') cursor.lineNo++;
+		cursor.at++;
+		return;
+	}
+
+	cursor.at = scanKernels().skipWhitespace(cursor.at, cursor.end, cursor.lineNo);
+}
+
+PeekToken peekToken(const Cursor& cursor)
+{
+	PeekToken pt = {};
+	pt.futureCursor = cursor;
+
+	pt.token = getToken(pt.futureCursor);
+	return pt;
+}
+
+Token getToken(Cursor& cursor)
+{
+	Token t = {};
+	t.length = 1;
+
+	eatWhitespace(cursor);
+
+	if (cursor.at == cursor.end) return EOFToken();
+
+	t.str = cursor.at;
+
+	switch (*cursor.at)
+	{
+	case '{': t.type = Token::OPEN_BRACE;           break;
+	case '}': t.type = Token::CLOSE_BRACE;          break;
+	case ':': t.type = Token::COLON;			    break;
+	case ',': t.type = Token::COMMA;			    break;
+	case '[': t.type = Token::SQUARE_BRACKET_OPEN;  break;
+	case ']': t.type = Token::SQUARE_BRACKET_CLOSE; break;
+	case 'f':
+	case 't':
+	case 'n':
+		t = parseAlNumLiteralToken(cursor.at, cursor.end);
+		break;
+	case '"':
+		t = parseStringToken(cursor.at, cursor.end);
+		if (t.type == Token::UNKNOWN)
+		{
+			using namespace std::string_literals;
+			errors.push("Unknown token for assumed string literal. Check closing \"; LINENO: "s + std::to_string(cursor.lineNo));
+		}
+
+		break;
+	default:
+		if (isdigit(*cursor.at) || *cursor.at == '-')
+		{
+			t = parseNumToken(cursor.at, cursor.end);
+		}
+		else
+		{
+			return unknownToken();
+		}
+	}
+
+	cursor.at += t.length;
+	return t;
+}
+
+
+Token parseNumToken(const char * str, const char * end)
+{
+	// -? (0 | [1-9][0-9]*) (.[0-9]+)? ([eE][+-]?[0-9]+)?
+	const char* at = str;
+
+	if (charAt(at, end) == '-') at++;
+
+	if (charAt(at, end) == '0')
+		at++;
+	else if (isDigit(charAt(at, end)))
+		while (isDigit(charAt(at, end))) at++;
+	else
+		return unknownToken();
+
+	if (charAt(at, end) == '.')
+	{
+		at++;
+		if (!isDigit(charAt(at, end))) return unknownToken();
+		while (isDigit(charAt(at, end))) at++;
+	}
+
+	if (charAt(at, end) == 'e' || charAt(at, end) == 'E')
+	{
+		at++;
+		if (charAt(at, end) == '+' || charAt(at, end) == '-') at++;
+		if (!isDigit(charAt(at, end))) return unknownToken();
+		while (isDigit(charAt(at, end))) at++;
+	}
+
+	Token t = {};
+	t.type = Token::NUMBER;
+	t.str = str;
+	t.length = (int)(at - str);
+	return t;
+}
+
+Token parseStringToken(const char * str, const char * end)
+{
+	Token t = {};
+	t.str = str;
+
+	const ScanKernels& kernels = scanKernels();
+	const char* at = str + 1;
+
+	for (;;)
+	{
+		at = kernels.findQuoteOrEscape(at, end);
+
+		if (at == end || *at == 0 || (*at == '\\' && at + 1 == end)) return unknownToken();
+		if (*at == '"') break;
+
+		// skip the escaped character, whatever it is
+		t.hasEscapes = true;
+		at += 2;
+	}
+
+	t.length = (int)(at - str) + 1;
+	t.type = Token::STRING;
+	return t;
+}
+
+Token parseAlNumLiteralToken(const char * str, const char * end)
+{
+	constexpr const char* t = "true";
+	constexpr const char* f = "false";
+	constexpr const char* n = "null";
+
+	const size_t available = end - str;
+
+	Token token = {};
+	token.str = str;
+
+	if (available >= strlen(t) && cmpSubStr(str, t, strlen(t)))
+	{
+		token.length = strlen(t);
+		token.type = Token::BOOL;
+	}
+	else if (available >= strlen(f) && cmpSubStr(str, f, strlen(f)))
+	{
+		token.length = strlen(f);
+		token.type = Token::BOOL;
+	}
+	else if (available >= strlen(n) && cmpSubStr(str, n, strlen(n)))
+	{
+		token.length = strlen(n);
+		token.type = Token::JSON_NULL;
+	}
+	else
+	{
+		token = unknownToken();
+	}
+
+
+	return token;
+}
+
+
+// Number conversion. Tokens are already validated by parseNumToken, so only the value is
+// computed here: integers and short decimals are exact in a double operation or two,
+// everything else with up to 19 significant digits goes through Eisel-Lemire.
+// Formatting goes the other way with Schubfach, which finds the shortest digits that
+// still parse back to the same double.
+
+static constexpr int POWER_OF_FIVE_MIN = -342;
+static constexpr int POWER_OF_FIVE_MAX = 326;
+
+// 5^q for q in [POWER_OF_FIVE_MIN, POWER_OF_FIVE_MAX], normalized to 128 bits (high, low).
+// q in [-27, -1] is rounded up, everything else truncated. Parsing needs q up to 308,
+// formatting down to -292
+static const uint64_t POWERS_OF_FIVE[] = {
+	0xeef453d6923bd65a, 0x113faa2906a13b3f,
+	0x9558b4661b6565f8, 0x4ac7ca59a424c507,
+	0xbaaee17fa23ebf76, 0x5d79bcf00d2df649,
+	0xe95a99df8ace6f53, 0xf4d82c2c107973dc,
+	0x91d8a02bb6c10594, 0x79071b9b8a4be869,
+	0xb64ec836a47146f9, 0x9748e2826cdee284,
+	0xe3e27a444d8d98b7, 0xfd1b1b2308169b25,
+	0x8e6d8c6ab0787f72, 0xfe30f0f5e50e20f7,
+	0xb208ef855c969f4f, 0xbdbd2d335e51a935,
+	0xde8b2b66b3bc4723, 0xad2c788035e61382,
+	0x8b16fb203055ac76, 0x4c3bcb5021afcc31,
+	0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3d,
+	0xd953e8624b85dd78, 0xd71d6dad34a2af0d,
+	0x87d4713d6f33aa6b, 0x8672648c40e5ad68,
+	0xa9c98d8ccb009506, 0x680efdaf511f18c2,
+	0xd43bf0effdc0ba48, 0x0212bd1b2566def2,
+	0x84a57695fe98746d, 0x014bb630f7604b57,
+	0xa5ced43b7e3e9188, 0x419ea3bd35385e2d,
+	0xcf42894a5dce35ea, 0x52064cac828675b9,
+	0x818995ce7aa0e1b2, 0x7343efebd1940993,
+	0xa1ebfb4219491a1f, 0x1014ebe6c5f90bf8,
+	0xca66fa129f9b60a6, 0xd41a26e077774ef6,
+	0xfd00b897478238d0, 0x8920b098955522b4,
+	0x9e20735e8cb16382, 0x55b46e5f5d5535b0,
+	0xc5a890362fddbc62, 0xeb2189f734aa831d,
+	0xf712b443bbd52b7b, 0xa5e9ec7501d523e4,
+	0x9a6bb0aa55653b2d, 0x47b233c92125366e,
+	0xc1069cd4eabe89f8, 0x999ec0bb696e840a,
+	0xf148440a256e2c76, 0xc00670ea43ca250d,
+	0x96cd2a865764dbca, 0x380406926a5e5728,
+	0xbc807527ed3e12bc, 0xc605083704f5ecf2,
+	0xeba09271e88d976b, 0xf7864a44c633682e,
+	0x93445b8731587ea3, 0x7ab3ee6afbe0211d,
+	0xb8157268fdae9e4c, 0x5960ea05bad82964,
+	0xe61acf033d1a45df, 0x6fb92487298e33bd,
+	0x8fd0c16206306bab, 0xa5d3b6d479f8e056,
+	0xb3c4f1ba87bc8696, 0x8f48a4899877186c,
+	0xe0b62e2929aba83c, 0x331acdabfe94de87,
+	0x8c71dcd9ba0b4925, 0x9ff0c08b7f1d0b14,
+	0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dd9,
+	0xdb71e91432b1a24a, 0xc9e82cd9f69d6150,
+	0x892731ac9faf056e, 0xbe311c083a225cd2,
+	0xab70fe17c79ac6ca, 0x6dbd630a48aaf406,
+	0xd64d3d9db981787d, 0x092cbbccdad5b108,
+	0x85f0468293f0eb4e, 0x25bbf56008c58ea5,
+	0xa76c582338ed2621, 0xaf2af2b80af6f24e,
+	0xd1476e2c07286faa, 0x1af5af660db4aee1,
+	0x82cca4db847945ca, 0x50d98d9fc890ed4d,
+	0xa37fce126597973c, 0xe50ff107bab528a0,
+	0xcc5fc196fefd7d0c, 0x1e53ed49a96272c8,
+	0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7a,
+	0x9faacf3df73609b1, 0x77b191618c54e9ac,
+	0xc795830d75038c1d, 0xd59df5b9ef6a2417,
+	0xf97ae3d0d2446f25, 0x4b0573286b44ad1d,
+	0x9becce62836ac577, 0x4ee367f9430aec32,
+	0xc2e801fb244576d5, 0x229c41f793cda73f,
+	0xf3a20279ed56d48a, 0x6b43527578c1110f,
+	0x9845418c345644d6, 0x830a13896b78aaa9,
+	0xbe5691ef416bd60c, 0x23cc986bc656d553,
+	0xedec366b11c6cb8f, 0x2cbfbe86b7ec8aa8,
+	0x94b3a202eb1c3f39, 0x7bf7d71432f3d6a9,
+	0xb9e08a83a5e34f07, 0xdaf5ccd93fb0cc53,
+	0xe858ad248f5c22c9, 0xd1b3400f8f9cff68,
+	0x91376c36d99995be, 0x23100809b9c21fa1,
+	0xb58547448ffffb2d, 0xabd40a0c2832a78a,
+	0xe2e69915b3fff9f9, 0x16c90c8f323f516c,
+	0x8dd01fad907ffc3b, 0xae3da7d97f6792e3,
+	0xb1442798f49ffb4a, 0x99cd11cfdf41779c,
+	0xdd95317f31c7fa1d, 0x40405643d711d583,
+	0x8a7d3eef7f1cfc52, 0x482835ea666b2572,
+	0xad1c8eab5ee43b66, 0xda3243650005eecf,
+	0xd863b256369d4a40, 0x90bed43e40076a82,
+	0x873e4f75e2224e68, 0x5a7744a6e804a291,
+	0xa90de3535aaae202, 0x711515d0a205cb36,
+	0xd3515c2831559a83, 0x0d5a5b44ca873e03,
+	0x8412d9991ed58091, 0xe858790afe9486c2,
+	0xa5178fff668ae0b6, 0x626e974dbe39a872,
+	0xce5d73ff402d98e3, 0xfb0a3d212dc8128f,
+	0x80fa687f881c7f8e, 0x7ce66634bc9d0b99,
+	0xa139029f6a239f72, 0x1c1fffc1ebc44e80,
+	0xc987434744ac874e, 0xa327ffb266b56220,
+	0xfbe9141915d7a922, 0x4bf1ff9f0062baa8,
+	0x9d71ac8fada6c9b5, 0x6f773fc3603db4a9,
+	0xc4ce17b399107c22, 0xcb550fb4384d21d3,
+	0xf6019da07f549b2b, 0x7e2a53a146606a48,
+	0x99c102844f94e0fb, 0x2eda7444cbfc426d,
+	0xc0314325637a1939, 0xfa911155fefb5308,
+	0xf03d93eebc589f88, 0x793555ab7eba27ca,
+	0x96267c7535b763b5, 0x4bc1558b2f3458de,
+	0xbbb01b9283253ca2, 0x9eb1aaedfb016f16,
+	0xea9c227723ee8bcb, 0x465e15a979c1cadc,
+	0x92a1958a7675175f, 0x0bfacd89ec191ec9,
+	0xb749faed14125d36, 0xcef980ec671f667b,
+	0xe51c79a85916f484, 0x82b7e12780e7401a,
+	0x8f31cc0937ae58d2, 0xd1b2ecb8b0908810,
+	0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15,
+	0xdfbdcece67006ac9, 0x67a791e093e1d49a,
+	0x8bd6a141006042bd, 0xe0c8bb2c5c6d24e0,
+	0xaecc49914078536d, 0x58fae9f773886e18,
+	0xda7f5bf590966848, 0xaf39a475506a899e,
+	0x888f99797a5e012d, 0x6d8406c952429603,
+	0xaab37fd7d8f58178, 0xc8e5087ba6d33b83,
+	0xd5605fcdcf32e1d6, 0xfb1e4a9a90880a64,
+	0x855c3be0a17fcd26, 0x5cf2eea09a55067f,
+	0xa6b34ad8c9dfc06f, 0xf42faa48c0ea481e,
+	0xd0601d8efc57b08b, 0xf13b94daf124da26,
+	0x823c12795db6ce57, 0x76c53d08d6b70858,
+	0xa2cb1717b52481ed, 0x54768c4b0c64ca6e,
+	0xcb7ddcdda26da268, 0xa9942f5dcf7dfd09,
+	0xfe5d54150b090b02, 0xd3f93b35435d7c4c,
+	0x9efa548d26e5a6e1, 0xc47bc5014a1a6daf,
+	0xc6b8e9b0709f109a, 0x359ab6419ca1091b,
+	0xf867241c8cc6d4c0, 0xc30163d203c94b62,
+	0x9b407691d7fc44f8, 0x79e0de63425dcf1d,
+	0xc21094364dfb5636, 0x985915fc12f542e4,
+	0xf294b943e17a2bc4, 0x3e6f5b7b17b2939d,
+	0x979cf3ca6cec5b5a, 0xa705992ceecf9c42,
+	0xbd8430bd08277231, 0x50c6ff782a838353,
+	0xece53cec4a314ebd, 0xa4f8bf5635246428,
+	0x940f4613ae5ed136, 0x871b7795e136be99,
+	0xb913179899f68584, 0x28e2557b59846e3f,
+	0xe757dd7ec07426e5, 0x331aeada2fe589cf,
+	0x9096ea6f3848984f, 0x3ff0d2c85def7621,
+	0xb4bca50b065abe63, 0x0fed077a756b53a9,
+	0xe1ebce4dc7f16dfb, 0xd3e8495912c62894,
+	0x8d3360f09cf6e4bd, 0x64712dd7abbbd95c,
+	0xb080392cc4349dec, 0xbd8d794d96aacfb3,
+	0xdca04777f541c567, 0xecf0d7a0fc5583a0,
+	0x89e42caaf9491b60, 0xf41686c49db57244,
+	0xac5d37d5b79b6239, 0x311c2875c522ced5,
+	0xd77485cb25823ac7, 0x7d633293366b828b,
+	0x86a8d39ef77164bc, 0xae5dff9c02033197,
+	0xa8530886b54dbdeb, 0xd9f57f830283fdfc,
+	0xd267caa862a12d66, 0xd072df63c324fd7b,
+	0x8380dea93da4bc60, 0x4247cb9e59f71e6d,
+	0xa46116538d0deb78, 0x52d9be85f074e608,
+	0xcd795be870516656, 0x67902e276c921f8b,
+	0x806bd9714632dff6, 0x00ba1cd8a3db53b6,
+	0xa086cfcd97bf97f3, 0x80e8a40eccd228a4,
+	0xc8a883c0fdaf7df0, 0x6122cd128006b2cd,
+	0xfad2a4b13d1b5d6c, 0x796b805720085f81,
+	0x9cc3a6eec6311a63, 0xcbe3303674053bb0,
+	0xc3f490aa77bd60fc, 0xbedbfc4411068a9c,
+	0xf4f1b4d515acb93b, 0xee92fb5515482d44,
+	0x991711052d8bf3c5, 0x751bdd152d4d1c4a,
+	0xbf5cd54678eef0b6, 0xd262d45a78a0635d,
+	0xef340a98172aace4, 0x86fb897116c87c34,
+	0x9580869f0e7aac0e, 0xd45d35e6ae3d4da0,
+	0xbae0a846d2195712, 0x8974836059cca109,
+	0xe998d258869facd7, 0x2bd1a438703fc94b,
+	0x91ff83775423cc06, 0x7b6306a34627ddcf,
+	0xb67f6455292cbf08, 0x1a3bc84c17b1d542,
+	0xe41f3d6a7377eeca, 0x20caba5f1d9e4a93,
+	0x8e938662882af53e, 0x547eb47b7282ee9c,
+	0xb23867fb2a35b28d, 0xe99e619a4f23aa43,
+	0xdec681f9f4c31f31, 0x6405fa00e2ec94d4,
+	0x8b3c113c38f9f37e, 0xde83bc408dd3dd04,
+	0xae0b158b4738705e, 0x9624ab50b148d445,
+	0xd98ddaee19068c76, 0x3badd624dd9b0957,
+	0x87f8a8d4cfa417c9, 0xe54ca5d70a80e5d6,
+	0xa9f6d30a038d1dbc, 0x5e9fcf4ccd211f4c,
+	0xd47487cc8470652b, 0x7647c3200069671f,
+	0x84c8d4dfd2c63f3b, 0x29ecd9f40041e073,
+	0xa5fb0a17c777cf09, 0xf468107100525890,
+	0xcf79cc9db955c2cc, 0x7182148d4066eeb4,
+	0x81ac1fe293d599bf, 0xc6f14cd848405530,
+	0xa21727db38cb002f, 0xb8ada00e5a506a7c,
+	0xca9cf1d206fdc03b, 0xa6d90811f0e4851c,
+	0xfd442e4688bd304a, 0x908f4a166d1da663,
+	0x9e4a9cec15763e2e, 0x9a598e4e043287fe,
+	0xc5dd44271ad3cdba, 0x40eff1e1853f29fd,
+	0xf7549530e188c128, 0xd12bee59e68ef47c,
+	0x9a94dd3e8cf578b9, 0x82bb74f8301958ce,
+	0xc13a148e3032d6e7, 0xe36a52363c1faf01,
+	0xf18899b1bc3f8ca1, 0xdc44e6c3cb279ac1,
+	0x96f5600f15a7b7e5, 0x29ab103a5ef8c0b9,
+	0xbcb2b812db11a5de, 0x7415d448f6b6f0e7,
+	0xebdf661791d60f56, 0x111b495b3464ad21,
+	0x936b9fcebb25c995, 0xcab10dd900beec34,
+	0xb84687c269ef3bfb, 0x3d5d514f40eea742,
+	0xe65829b3046b0afa, 0x0cb4a5a3112a5112,
+	0x8ff71a0fe2c2e6dc, 0x47f0e785eaba72ab,
+	0xb3f4e093db73a093, 0x59ed216765690f56,
+	0xe0f218b8d25088b8, 0x306869c13ec3532c,
+	0x8c974f7383725573, 0x1e414218c73a13fb,
+	0xafbd2350644eeacf, 0xe5d1929ef90898fa,
+	0xdbac6c247d62a583, 0xdf45f746b74abf39,
+	0x894bc396ce5da772, 0x6b8bba8c328eb783,
+	0xab9eb47c81f5114f, 0x066ea92f3f326564,
+	0xd686619ba27255a2, 0xc80a537b0efefebd,
+	0x8613fd0145877585, 0xbd06742ce95f5f36,
+	0xa798fc4196e952e7, 0x2c48113823b73704,
+	0xd17f3b51fca3a7a0, 0xf75a15862ca504c5,
+	0x82ef85133de648c4, 0x9a984d73dbe722fb,
+	0xa3ab66580d5fdaf5, 0xc13e60d0d2e0ebba,
+	0xcc963fee10b7d1b3, 0x318df905079926a8,
+	0xffbbcfe994e5c61f, 0xfdf17746497f7052,
+	0x9fd561f1fd0f9bd3, 0xfeb6ea8bedefa633,
+	0xc7caba6e7c5382c8, 0xfe64a52ee96b8fc0,
+	0xf9bd690a1b68637b, 0x3dfdce7aa3c673b0,
+	0x9c1661a651213e2d, 0x06bea10ca65c084e,
+	0xc31bfa0fe5698db8, 0x486e494fcff30a62,
+	0xf3e2f893dec3f126, 0x5a89dba3c3efccfa,
+	0x986ddb5c6b3a76b7, 0xf89629465a75e01c,
+	0xbe89523386091465, 0xf6bbb397f1135823,
+	0xee2ba6c0678b597f, 0x746aa07ded582e2c,
+	0x94db483840b717ef, 0xa8c2a44eb4571cdc,
+	0xba121a4650e4ddeb, 0x92f34d62616ce413,
+	0xe896a0d7e51e1566, 0x77b020baf9c81d17,
+	0x915e2486ef32cd60, 0x0ace1474dc1d122e,
+	0xb5b5ada8aaff80b8, 0x0d819992132456ba,
+	0xe3231912d5bf60e6, 0x10e1fff697ed6c69,
+	0x8df5efabc5979c8f, 0xca8d3ffa1ef463c1,
+	0xb1736b96b6fd83b3, 0xbd308ff8a6b17cb2,
+	0xddd0467c64bce4a0, 0xac7cb3f6d05ddbde,
+	0x8aa22c0dbef60ee4, 0x6bcdf07a423aa96b,
+	0xad4ab7112eb3929d, 0x86c16c98d2c953c6,
+	0xd89d64d57a607744, 0xe871c7bf077ba8b7,
+	0x87625f056c7c4a8b, 0x11471cd764ad4972,
+	0xa93af6c6c79b5d2d, 0xd598e40d3dd89bcf,
+	0xd389b47879823479, 0x4aff1d108d4ec2c3,
+	0x843610cb4bf160cb, 0xcedf722a585139ba,
+	0xa54394fe1eedb8fe, 0xc2974eb4ee658828,
+	0xce947a3da6a9273e, 0x733d226229feea32,
+	0x811ccc668829b887, 0x0806357d5a3f525f,
+	0xa163ff802a3426a8, 0xca07c2dcb0cf26f7,
+	0xc9bcff6034c13052, 0xfc89b393dd02f0b5,
+	0xfc2c3f3841f17c67, 0xbbac2078d443ace2,
+	0x9d9ba7832936edc0, 0xd54b944b84aa4c0d,
+	0xc5029163f384a931, 0x0a9e795e65d4df11,
+	0xf64335bcf065d37d, 0x4d4617b5ff4a16d5,
+	0x99ea0196163fa42e, 0x504bced1bf8e4e45,
+	0xc06481fb9bcf8d39, 0xe45ec2862f71e1d6,
+	0xf07da27a82c37088, 0x5d767327bb4e5a4c,
+	0x964e858c91ba2655, 0x3a6a07f8d510f86f,
+	0xbbe226efb628afea, 0x890489f70a55368b,
+	0xeadab0aba3b2dbe5, 0x2b45ac74ccea842e,
+	0x92c8ae6b464fc96f, 0x3b0b8bc90012929d,
+	0xb77ada0617e3bbcb, 0x09ce6ebb40173744,
+	0xe55990879ddcaabd, 0xcc420a6a101d0515,
+	0x8f57fa54c2a9eab6, 0x9fa946824a12232d,
+	0xb32df8e9f3546564, 0x47939822dc96abf9,
+	0xdff9772470297ebd, 0x59787e2b93bc56f7,
+	0x8bfbea76c619ef36, 0x57eb4edb3c55b65a,
+	0xaefae51477a06b03, 0xede622920b6b23f1,
+	0xdab99e59958885c4, 0xe95fab368e45eced,
+	0x88b402f7fd75539b, 0x11dbcb0218ebb414,
+	0xaae103b5fcd2a881, 0xd652bdc29f26a119,
+	0xd59944a37c0752a2, 0x4be76d3346f0495f,
+	0x857fcae62d8493a5, 0x6f70a4400c562ddb,
+	0xa6dfbd9fb8e5b88e, 0xcb4ccd500f6bb952,
+	0xd097ad07a71f26b2, 0x7e2000a41346a7a7,
+	0x825ecc24c873782f, 0x8ed400668c0c28c8,
+	0xa2f67f2dfa90563b, 0x728900802f0f32fa,
+	0xcbb41ef979346bca, 0x4f2b40a03ad2ffb9,
+	0xfea126b7d78186bc, 0xe2f610c84987bfa8,
+	0x9f24b832e6b0f436, 0x0dd9ca7d2df4d7c9,
+	0xc6ede63fa05d3143, 0x91503d1c79720dbb,
+	0xf8a95fcf88747d94, 0x75a44c6397ce912a,
+	0x9b69dbe1b548ce7c, 0xc986afbe3ee11aba,
+	0xc24452da229b021b, 0xfbe85badce996168,
+	0xf2d56790ab41c2a2, 0xfae27299423fb9c3,
+	0x97c560ba6b0919a5, 0xdccd879fc967d41a,
+	0xbdb6b8e905cb600f, 0x5400e987bbc1c920,
+	0xed246723473e3813, 0x290123e9aab23b68,
+	0x9436c0760c86e30b, 0xf9a0b6720aaf6521,
+	0xb94470938fa89bce, 0xf808e40e8d5b3e69,
+	0xe7958cb87392c2c2, 0xb60b1d1230b20e04,
+	0x90bd77f3483bb9b9, 0xb1c6f22b5e6f48c2,
+	0xb4ecd5f01a4aa828, 0x1e38aeb6360b1af3,
+	0xe2280b6c20dd5232, 0x25c6da63c38de1b0,
+	0x8d590723948a535f, 0x579c487e5a38ad0e,
+	0xb0af48ec79ace837, 0x2d835a9df0c6d851,
+	0xdcdb1b2798182244, 0xf8e431456cf88e65,
+	0x8a08f0f8bf0f156b, 0x1b8e9ecb641b58ff,
+	0xac8b2d36eed2dac5, 0xe272467e3d222f3f,
+	0xd7adf884aa879177, 0x5b0ed81dcc6abb0f,
+	0x86ccbb52ea94baea, 0x98e947129fc2b4e9,
+	0xa87fea27a539e9a5, 0x3f2398d747b36224,
+	0xd29fe4b18e88640e, 0x8eec7f0d19a03aad,
+	0x83a3eeeef9153e89, 0x1953cf68300424ac,
+	0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7,
+	0xcdb02555653131b6, 0x3792f412cb06794d,
+	0x808e17555f3ebf11, 0xe2bbd88bbee40bd0,
+	0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4,
+	0xc8de047564d20a8b, 0xf245825a5a445275,
+	0xfb158592be068d2e, 0xeed6e2f0f0d56712,
+	0x9ced737bb6c4183d, 0x55464dd69685606b,
+	0xc428d05aa4751e4c, 0xaa97e14c3c26b886,
+	0xf53304714d9265df, 0xd53dd99f4b3066a8,
+	0x993fe2c6d07b7fab, 0xe546a8038efe4029,
+	0xbf8fdb78849a5f96, 0xde98520472bdd033,
+	0xef73d256a5c0f77c, 0x963e66858f6d4440,
+	0x95a8637627989aad, 0xdde7001379a44aa8,
+	0xbb127c53b17ec159, 0x5560c018580d5d52,
+	0xe9d71b689dde71af, 0xaab8f01e6e10b4a6,
+	0x9226712162ab070d, 0xcab3961304ca70e8,
+	0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22,
+	0xe45c10c42a2b3b05, 0x8cb89a7db77c506a,
+	0x8eb98a7a9a5b04e3, 0x77f3608e92adb242,
+	0xb267ed1940f1c61c, 0x55f038b237591ed3,
+	0xdf01e85f912e37a3, 0x6b6c46dec52f6688,
+	0x8b61313bbabce2c6, 0x2323ac4b3b3da015,
+	0xae397d8aa96c1b77, 0xabec975e0a0d081a,
+	0xd9c7dced53c72255, 0x96e7bd358c904a21,
+	0x881cea14545c7575, 0x7e50d64177da2e54,
+	0xaa242499697392d2, 0xdde50bd1d5d0b9e9,
+	0xd4ad2dbfc3d07787, 0x955e4ec64b44e864,
+	0x84ec3c97da624ab4, 0xbd5af13bef0b113e,
+	0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e,
+	0xcfb11ead453994ba, 0x67de18eda5814af2,
+	0x81ceb32c4b43fcf4, 0x80eacf948770ced7,
+	0xa2425ff75e14fc31, 0xa1258379a94d028d,
+	0xcad2f7f5359a3b3e, 0x096ee45813a04330,
+	0xfd87b5f28300ca0d, 0x8bca9d6e188853fc,
+	0x9e74d1b791e07e48, 0x775ea264cf55347e,
+	0xc612062576589dda, 0x95364afe032a819e,
+	0xf79687aed3eec551, 0x3a83ddbd83f52205,
+	0x9abe14cd44753b52, 0xc4926a9672793543,
+	0xc16d9a0095928a27, 0x75b7053c0f178294,
+	0xf1c90080baf72cb1, 0x5324c68b12dd6339,
+	0x971da05074da7bee, 0xd3f6fc16ebca5e04,
+	0xbce5086492111aea, 0x88f4bb1ca6bcf585,
+	0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6,
+	0x9392ee8e921d5d07, 0x3aff322e62439fd0,
+	0xb877aa3236a4b449, 0x09befeb9fad487c3,
+	0xe69594bec44de15b, 0x4c2ebe687989a9b4,
+	0x901d7cf73ab0acd9, 0x0f9d37014bf60a11,
+	0xb424dc35095cd80f, 0x538484c19ef38c95,
+	0xe12e13424bb40e13, 0x2865a5f206b06fba,
+	0x8cbccc096f5088cb, 0xf93f87b7442e45d4,
+	0xafebff0bcb24aafe, 0xf78f69a51539d749,
+	0xdbe6fecebdedd5be, 0xb573440e5a884d1c,
+	0x89705f4136b4a597, 0x31680a88f8953031,
+	0xabcc77118461cefc, 0xfdc20d2b36ba7c3e,
+	0xd6bf94d5e57a42bc, 0x3d32907604691b4d,
+	0x8637bd05af6c69b5, 0xa63f9a49c2c1b110,
+	0xa7c5ac471b478423, 0x0fcf80dc33721d54,
+	0xd1b71758e219652b, 0xd3c36113404ea4a9,
+	0x83126e978d4fdf3b, 0x645a1cac083126ea,
+	0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4,
+	0xcccccccccccccccc, 0xcccccccccccccccd,
+	0x8000000000000000, 0x0000000000000000,
+	0xa000000000000000, 0x0000000000000000,
+	0xc800000000000000, 0x0000000000000000,
+	0xfa00000000000000, 0x0000000000000000,
+	0x9c40000000000000, 0x0000000000000000,
+	0xc350000000000000, 0x0000000000000000,
+	0xf424000000000000, 0x0000000000000000,
+	0x9896800000000000, 0x0000000000000000,
+	0xbebc200000000000, 0x0000000000000000,
+	0xee6b280000000000, 0x0000000000000000,
+	0x9502f90000000000, 0x0000000000000000,
+	0xba43b74000000000, 0x0000000000000000,
+	0xe8d4a51000000000, 0x0000000000000000,
+	0x9184e72a00000000, 0x0000000000000000,
+	0xb5e620f480000000, 0x0000000000000000,
+	0xe35fa931a0000000, 0x0000000000000000,
+	0x8e1bc9bf04000000, 0x0000000000000000,
+	0xb1a2bc2ec5000000, 0x0000000000000000,
+	0xde0b6b3a76400000, 0x0000000000000000,
+	0x8ac7230489e80000, 0x0000000000000000,
+	0xad78ebc5ac620000, 0x0000000000000000,
+	0xd8d726b7177a8000, 0x0000000000000000,
+	0x878678326eac9000, 0x0000000000000000,
+	0xa968163f0a57b400, 0x0000000000000000,
+	0xd3c21bcecceda100, 0x0000000000000000,
+	0x84595161401484a0, 0x0000000000000000,
+	0xa56fa5b99019a5c8, 0x0000000000000000,
+	0xcecb8f27f4200f3a, 0x0000000000000000,
+	0x813f3978f8940984, 0x4000000000000000,
+	0xa18f07d736b90be5, 0x5000000000000000,
+	0xc9f2c9cd04674ede, 0xa400000000000000,
+	0xfc6f7c4045812296, 0x4d00000000000000,
+	0x9dc5ada82b70b59d, 0xf020000000000000,
+	0xc5371912364ce305, 0x6c28000000000000,
+	0xf684df56c3e01bc6, 0xc732000000000000,
+	0x9a130b963a6c115c, 0x3c7f400000000000,
+	0xc097ce7bc90715b3, 0x4b9f100000000000,
+	0xf0bdc21abb48db20, 0x1e86d40000000000,
+	0x96769950b50d88f4, 0x1314448000000000,
+	0xbc143fa4e250eb31, 0x17d955a000000000,
+	0xeb194f8e1ae525fd, 0x5dcfab0800000000,
+	0x92efd1b8d0cf37be, 0x5aa1cae500000000,
+	0xb7abc627050305ad, 0xf14a3d9e40000000,
+	0xe596b7b0c643c719, 0x6d9ccd05d0000000,
+	0x8f7e32ce7bea5c6f, 0xe4820023a2000000,
+	0xb35dbf821ae4f38b, 0xdda2802c8a800000,
+	0xe0352f62a19e306e, 0xd50b2037ad200000,
+	0x8c213d9da502de45, 0x4526f422cc340000,
+	0xaf298d050e4395d6, 0x9670b12b7f410000,
+	0xdaf3f04651d47b4c, 0x3c0cdd765f114000,
+	0x88d8762bf324cd0f, 0xa5880a69fb6ac800,
+	0xab0e93b6efee0053, 0x8eea0d047a457a00,
+	0xd5d238a4abe98068, 0x72a4904598d6d880,
+	0x85a36366eb71f041, 0x47a6da2b7f864750,
+	0xa70c3c40a64e6c51, 0x999090b65f67d924,
+	0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6d,
+	0x82818f1281ed449f, 0xbff8f10e7a8921a4,
+	0xa321f2d7226895c7, 0xaff72d52192b6a0d,
+	0xcbea6f8ceb02bb39, 0x9bf4f8a69f764490,
+	0xfee50b7025c36a08, 0x02f236d04753d5b4,
+	0x9f4f2726179a2245, 0x01d762422c946590,
+	0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef5,
+	0xf8ebad2b84e0d58b, 0xd2e0898765a7deb2,
+	0x9b934c3b330c8577, 0x63cc55f49f88eb2f,
+	0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fb,
+	0xf316271c7fc3908a, 0x8bef464e3945ef7a,
+	0x97edd871cfda3a56, 0x97758bf0e3cbb5ac,
+	0xbde94e8e43d0c8ec, 0x3d52eeed1cbea317,
+	0xed63a231d4c4fb27, 0x4ca7aaa863ee4bdd,
+	0x945e455f24fb1cf8, 0x8fe8caa93e74ef6a,
+	0xb975d6b6ee39e436, 0xb3e2fd538e122b44,
+	0xe7d34c64a9c85d44, 0x60dbbca87196b616,
+	0x90e40fbeea1d3a4a, 0xbc8955e946fe31cd,
+	0xb51d13aea4a488dd, 0x6babab6398bdbe41,
+	0xe264589a4dcdab14, 0xc696963c7eed2dd1,
+	0x8d7eb76070a08aec, 0xfc1e1de5cf543ca2,
+	0xb0de65388cc8ada8, 0x3b25a55f43294bcb,
+	0xdd15fe86affad912, 0x49ef0eb713f39ebe,
+	0x8a2dbf142dfcc7ab, 0x6e3569326c784337,
+	0xacb92ed9397bf996, 0x49c2c37f07965404,
+	0xd7e77a8f87daf7fb, 0xdc33745ec97be906,
+	0x86f0ac99b4e8dafd, 0x69a028bb3ded71a3,
+	0xa8acd7c0222311bc, 0xc40832ea0d68ce0c,
+	0xd2d80db02aabd62b, 0xf50a3fa490c30190,
+	0x83c7088e1aab65db, 0x792667c6da79e0fa,
+	0xa4b8cab1a1563f52, 0x577001b891185938,
+	0xcde6fd5e09abcf26, 0xed4c0226b55e6f86,
+	0x80b05e5ac60b6178, 0x544f8158315b05b4,
+	0xa0dc75f1778e39d6, 0x696361ae3db1c721,
+	0xc913936dd571c84c, 0x03bc3a19cd1e38e9,
+	0xfb5878494ace3a5f, 0x04ab48a04065c723,
+	0x9d174b2dcec0e47b, 0x62eb0d64283f9c76,
+	0xc45d1df942711d9a, 0x3ba5d0bd324f8394,
+	0xf5746577930d6500, 0xca8f44ec7ee36479,
+	0x9968bf6abbe85f20, 0x7e998b13cf4e1ecb,
+	0xbfc2ef456ae276e8, 0x9e3fedd8c321a67e,
+	0xefb3ab16c59b14a2, 0xc5cfe94ef3ea101e,
+	0x95d04aee3b80ece5, 0xbba1f1d158724a12,
+	0xbb445da9ca61281f, 0x2a8a6e45ae8edc97,
+	0xea1575143cf97226, 0xf52d09d71a3293bd,
+	0x924d692ca61be758, 0x593c2626705f9c56,
+	0xb6e0c377cfa2e12e, 0x6f8b2fb00c77836c,
+	0xe498f455c38b997a, 0x0b6dfb9c0f956447,
+	0x8edf98b59a373fec, 0x4724bd4189bd5eac,
+	0xb2977ee300c50fe7, 0x58edec91ec2cb657,
+	0xdf3d5e9bc0f653e1, 0x2f2967b66737e3ed,
+	0x8b865b215899f46c, 0xbd79e0d20082ee74,
+	0xae67f1e9aec07187, 0xecd8590680a3aa11,
+	0xda01ee641a708de9, 0xe80e6f4820cc9495,
+	0x884134fe908658b2, 0x3109058d147fdcdd,
+	0xaa51823e34a7eede, 0xbd4b46f0599fd415,
+	0xd4e5e2cdc1d1ea96, 0x6c9e18ac7007c91a,
+	0x850fadc09923329e, 0x03e2cf6bc604ddb0,
+	0xa6539930bf6bff45, 0x84db8346b786151c,
+	0xcfe87f7cef46ff16, 0xe612641865679a63,
+	0x81f14fae158c5f6e, 0x4fcb7e8f3f60c07e,
+	0xa26da3999aef7749, 0xe3be5e330f38f09d,
+	0xcb090c8001ab551c, 0x5cadf5bfd3072cc5,
+	0xfdcb4fa002162a63, 0x73d9732fc7c8f7f6,
+	0x9e9f11c4014dda7e, 0x2867e7fddcdd9afa,
+	0xc646d63501a1511d, 0xb281e1fd541501b8,
+	0xf7d88bc24209a565, 0x1f225a7ca91a4226,
+	0x9ae757596946075f, 0x3375788de9b06958,
+	0xc1a12d2fc3978937, 0x0052d6b1641c83ae,
+	0xf209787bb47d6b84, 0xc0678c5dbd23a49a,
+	0x9745eb4d50ce6332, 0xf840b7ba963646e0,
+	0xbd176620a501fbff, 0xb650e5a93bc3d898,
+	0xec5d3fa8ce427aff, 0xa3e51f138ab4cebe,
+	0x93ba47c980e98cdf, 0xc66f336c36b10137,
+	0xb8a8d9bbe123f017, 0xb80b0047445d4184,
+	0xe6d3102ad96cec1d, 0xa60dc059157491e5,
+	0x9043ea1ac7e41392, 0x87c89837ad68db2f,
+	0xb454e4a179dd1877, 0x29babe4598c311fb,
+	0xe16a1dc9d8545e94, 0xf4296dd6fef3d67a,
+	0x8ce2529e2734bb1d, 0x1899e4a65f58660c,
+	0xb01ae745b101e9e4, 0x5ec05dcff72e7f8f,
+	0xdc21a1171d42645d, 0x76707543f4fa1f73,
+	0x899504ae72497eba, 0x6a06494a791c53a8,
+	0xabfa45da0edbde69, 0x0487db9d17636892,
+	0xd6f8d7509292d603, 0x45a9d2845d3c42b6,
+	0x865b86925b9bc5c2, 0x0b8a2392ba45a9b2,
+	0xa7f26836f282b732, 0x8e6cac7768d7141e,
+	0xd1ef0244af2364ff, 0x3207d795430cd926,
+	0x8335616aed761f1f, 0x7f44e6bd49e807b8,
+	0xa402b9c5a8d3a6e7, 0x5f16206c9c6209a6,
+	0xcd036837130890a1, 0x36dba887c37a8c0f,
+	0x802221226be55a64, 0xc2494954da2c9789,
+	0xa02aa96b06deb0fd, 0xf2db9baa10b7bd6c,
+	0xc83553c5c8965d3d, 0x6f92829494e5acc7,
+	0xfa42a8b73abbf48c, 0xcb772339ba1f17f9,
+	0x9c69a97284b578d7, 0xff2a760414536efb,
+	0xc38413cf25e2d70d, 0xfef5138519684aba,
+	0xf46518c2ef5b8cd1, 0x7eb258665fc25d69,
+	0x98bf2f79d5993802, 0xef2f773ffbd97a61,
+	0xbeeefb584aff8603, 0xaafb550ffacfd8fa,
+	0xeeaaba2e5dbf6784, 0x95ba2a53f983cf38,
+	0x952ab45cfa97a0b2, 0xdd945a747bf26183,
+	0xba756174393d88df, 0x94f971119aeef9e4,
+	0xe912b9d1478ceb17, 0x7a37cd5601aab85d,
+	0x91abb422ccb812ee, 0xac62e055c10ab33a,
+	0xb616a12b7fe617aa, 0x577b986b314d6009,
+	0xe39c49765fdf9d94, 0xed5a7e85fda0b80b,
+	0x8e41ade9fbebc27d, 0x14588f13be847307,
+	0xb1d219647ae6b31c, 0x596eb2d8ae258fc8,
+	0xde469fbd99a05fe3, 0x6fca5f8ed9aef3bb,
+	0x8aec23d680043bee, 0x25de7bb9480d5854,
+	0xada72ccc20054ae9, 0xaf561aa79a10ae6a,
+	0xd910f7ff28069da4, 0x1b2ba1518094da04,
+	0x87aa9aff79042286, 0x90fb44d2f05d0842,
+	0xa99541bf57452b28, 0x353a1607ac744a53,
+	0xd3fa922f2d1675f2, 0x42889b8997915ce8,
+	0x847c9b5d7c2e09b7, 0x69956135febada11,
+	0xa59bc234db398c25, 0x43fab9837e699095,
+	0xcf02b2c21207ef2e, 0x94f967e45e03f4bb,
+	0x8161afb94b44f57d, 0x1d1be0eebac278f5,
+	0xa1ba1ba79e1632dc, 0x6462d92a69731732,
+	0xca28a291859bbf93, 0x7d7b8f7503cfdcfe,
+	0xfcb2cb35e702af78, 0x5cda735244c3d43e,
+	0x9defbf01b061adab, 0x3a0888136afa64a7,
+	0xc56baec21c7a1916, 0x088aaa1845b8fdd0,
+	0xf6c69a72a3989f5b, 0x8aad549e57273d45,
+	0x9a3c2087a63f6399, 0x36ac54e2f678864b,
+	0xc0cb28a98fcf3c7f, 0x84576a1bb416a7dd,
+	0xf0fdf2d3f3c30b9f, 0x656d44a2a11c51d5,
+	0x969eb7c47859e743, 0x9f644ae5a4b1b325,
+	0xbc4665b596706114, 0x873d5d9f0dde1fee,
+	0xeb57ff22fc0c7959, 0xa90cb506d155a7ea,
+	0x9316ff75dd87cbd8, 0x09a7f12442d588f2,
+	0xb7dcbf5354e9bece, 0x0c11ed6d538aeb2f,
+	0xe5d3ef282a242e81, 0x8f1668c8a86da5fa,
+	0x8fa475791a569d10, 0xf96e017d694487bc,
+	0xb38d92d760ec4455, 0x37c981dcc395a9ac,
+	0xe070f78d3927556a, 0x85bbe253f47b1417,
+	0x8c469ab843b89562, 0x93956d7478ccec8e,
+	0xaf58416654a6babb, 0x387ac8d1970027b2,
+	0xdb2e51bfe9d0696a, 0x06997b05fcc0319e,
+	0x88fcf317f22241e2, 0x441fece3bdf81f03,
+	0xab3c2fddeeaad25a, 0xd527e81cad7626c3,
+	0xd60b3bd56a5586f1, 0x8a71e223d8d3b074,
+	0x85c7056562757456, 0xf6872d5667844e49,
+	0xa738c6bebb12d16c, 0xb428f8ac016561db,
+	0xd106f86e69d785c7, 0xe13336d701beba52,
+	0x82a45b450226b39c, 0xecc0024661173473,
+	0xa34d721642b06084, 0x27f002d7f95d0190,
+	0xcc20ce9bd35c78a5, 0x31ec038df7b441f4,
+	0xff290242c83396ce, 0x7e67047175a15271,
+	0x9f79a169bd203e41, 0x0f0062c6e984d386,
+	0xc75809c42c684dd1, 0x52c07b78a3e60868,
+	0xf92e0c3537826145, 0xa7709a56ccdf8a82,
+	0x9bbcc7a142b17ccb, 0x88a66076400bb691,
+	0xc2abf989935ddbfe, 0x6acff893d00ea435,
+	0xf356f7ebf83552fe, 0x0583f6b8c4124d43,
+	0x98165af37b2153de, 0xc3727a337a8b704a,
+	0xbe1bf1b059e9a8d6, 0x744f18c0592e4c5c,
+	0xeda2ee1c7064130c, 0x1162def06f79df73,
+	0x9485d4d1c63e8be7, 0x8addcb5645ac2ba8,
+	0xb9a74a0637ce2ee1, 0x6d953e2bd7173692,
+	0xe8111c87c5c1ba99, 0xc8fa8db6ccdd0437,
+	0x910ab1d4db9914a0, 0x1d9c9892400a22a2,
+	0xb54d5e4a127f59c8, 0x2503beb6d00cab4b,
+	0xe2a0b5dc971f303a, 0x2e44ae64840fd61d,
+	0x8da471a9de737e24, 0x5ceaecfed289e5d2,
+	0xb10d8e1456105dad, 0x7425a83e872c5f47,
+	0xdd50f1996b947518, 0xd12f124e28f77719,
+	0x8a5296ffe33cc92f, 0x82bd6b70d99aaa6f,
+	0xace73cbfdc0bfb7b, 0x636cc64d1001550b,
+	0xd8210befd30efa5a, 0x3c47f7e05401aa4e,
+	0x8714a775e3e95c78, 0x65acfaec34810a71,
+	0xa8d9d1535ce3b396, 0x7f1839a741a14d0d,
+	0xd31045a8341ca07c, 0x1ede48111209a050,
+	0x83ea2b892091e44d, 0x934aed0aab460432,
+	0xa4e4b66b68b65d60, 0xf81da84d5617853f,
+	0xce1de40642e3f4b9, 0x36251260ab9d668e,
+	0x80d2ae83e9ce78f3, 0xc1d72b7c6b426019,
+	0xa1075a24e4421730, 0xb24cf65b8612f81f,
+	0xc94930ae1d529cfc, 0xdee033f26797b627,
+	0xfb9b7cd9a4a7443c, 0x169840ef017da3b1,
+	0x9d412e0806e88aa5, 0x8e1f289560ee864e,
+	0xc491798a08a2ad4e, 0xf1a6f2bab92a27e2,
+	0xf5b5d7ec8acb58a2, 0xae10af696774b1db,
+	0x9991a6f3d6bf1765, 0xacca6da1e0a8ef29,
+	0xbff610b0cc6edd3f, 0x17fd090a58d32af3,
+	0xeff394dcff8a948e, 0xddfc4b4cef07f5b0,
+	0x95f83d0a1fb69cd9, 0x4abdaf101564f98e,
+	0xbb764c4ca7a4440f, 0x9d6d1ad41abe37f1,
+	0xea53df5fd18d5513, 0x84c86189216dc5ed,
+	0x92746b9be2f8552c, 0x32fd3cf5b4e49bb4,
+	0xb7118682dbb66a77, 0x3fbc8c33221dc2a1,
+	0xe4d5e82392a40515, 0x0fabaf3feaa5334a,
+	0x8f05b1163ba6832d, 0x29cb4d87f2a7400e,
+	0xb2c71d5bca9023f8, 0x743e20e9ef511012,
+	0xdf78e4b2bd342cf6, 0x914da9246b255416,
+	0x8bab8eefb6409c1a, 0x1ad089b6c2f7548e,
+	0xae9672aba3d0c320, 0xa184ac2473b529b1,
+	0xda3c0f568cc4f3e8, 0xc9e5d72d90a2741e,
+	0x8865899617fb1871, 0x7e2fa67c7a658892,
+	0xaa7eebfb9df9de8d, 0xddbb901b98feeab7,
+	0xd51ea6fa85785631, 0x552a74227f3ea565,
+	0x8533285c936b35de, 0xd53a88958f87275f,
+	0xa67ff273b8460356, 0x8a892abaf368f137,
+	0xd01fef10a657842c, 0x2d2b7569b0432d85,
+	0x8213f56a67f6b29b, 0x9c3b29620e29fc73,
+	0xa298f2c501f45f42, 0x8349f3ba91b47b8f,
+	0xcb3f2f7642717713, 0x241c70a936219a73,
+	0xfe0efb53d30dd4d7, 0xed238cd383aa0110,
+	0x9ec95d1463e8a506, 0xf4363804324a40aa,
+	0xc67bb4597ce2ce48, 0xb143c6053edcd0d5,
+	0xf81aa16fdc1b81da, 0xdd94b7868e94050a,
+	0x9b10a4e5e9913128, 0xca7cf2b4191c8326,
+	0xc1d4ce1f63f57d72, 0xfd1c2f611f63a3f0,
+	0xf24a01a73cf2dccf, 0xbc633b39673c8cec,
+	0x976e41088617ca01, 0xd5be0503e085d813,
+	0xbd49d14aa79dbc82, 0x4b2d8644d8a74e18,
+	0xec9c459d51852ba2, 0xddf8e7d60ed1219e,
+	0x93e1ab8252f33b45, 0xcabb90e5c942b503,
+	0xb8da1662e7b00a17, 0x3d6a751f3b936243,
+	0xe7109bfba19c0c9d, 0x0cc512670a783ad4,
+	0x906a617d450187e2, 0x27fb2b80668b24c5,
+	0xb484f9dc9641e9da, 0xb1f9f660802dedf6,
+	0xe1a63853bbd26451, 0x5e7873f8a0396973,
+	0x8d07e33455637eb2, 0xdb0b487b6423e1e8,
+	0xb049dc016abc5e5f, 0x91ce1a9a3d2cda62,
+	0xdc5c5301c56b75f7, 0x7641a140cc7810fb,
+	0x89b9b3e11b6329ba, 0xa9e904c87fcb0a9d,
+	0xac2820d9623bf429, 0x546345fa9fbdcd44,
+	0xd732290fbacaf133, 0xa97c177947ad4095,
+	0x867f59a9d4bed6c0, 0x49ed8eabcccc485d,
+	0xa81f301449ee8c70, 0x5c68f256bfff5a74,
+	0xd226fc195c6a2f8c, 0x73832eec6fff3111,
+	0x83585d8fd9c25db7, 0xc831fd53c5ff7eab,
+	0xa42e74f3d032f525, 0xba3e7ca8b77f5e55,
+	0xcd3a1230c43fb26f, 0x28ce1bd2e55f35eb,
+	0x80444b5e7aa7cf85, 0x7980d163cf5b81b3,
+	0xa0555e361951c366, 0xd7e105bcc332621f,
+	0xc86ab5c39fa63440, 0x8dd9472bf3fefaa7,
+	0xfa856334878fc150, 0xb14f98f6f0feb951,
+	0x9c935e00d4b9d8d2, 0x6ed1bf9a569f33d3,
+	0xc3b8358109e84f07, 0x0a862f80ec4700c8,
+	0xf4a642e14c6262c8, 0xcd27bb612758c0fa,
+	0x98e7e9cccfbd7dbd, 0x8038d51cb897789c,
+	0xbf21e44003acdd2c, 0xe0470a63e6bd56c3,
+	0xeeea5d5004981478, 0x1858ccfce06cac74,
+	0x95527a5202df0ccb, 0x0f37801e0c43ebc8,
+	0xbaa718e68396cffd, 0xd30560258f54e6ba,
+	0xe950df20247c83fd, 0x47c6b82ef32a2069,
+	0x91d28b7416cdd27e, 0x4cdc331d57fa5441,
+	0xb6472e511c81471d, 0xe0133fe4adf8e952,
+	0xe3d8f9e563a198e5, 0x58180fddd97723a6,
+	0x8e679c2f5e44ff8f, 0x570f09eaa7ea7648,
+	0xb201833b35d63f73, 0x2cd2cc6551e513da,
+	0xde81e40a034bcf4f, 0xf8077f7ea65e58d1,
+	0x8b112e86420f6191, 0xfb04afaf27faf782,
+	0xadd57a27d29339f6, 0x79c5db9af1f9b563,
+	0xd94ad8b1c7380874, 0x18375281ae7822bc,
+	0x87cec76f1c830548, 0x8f2293910d0b15b5,
+	0xa9c2794ae3a3c69a, 0xb2eb3875504ddb22,
+	0xd433179d9c8cb841, 0x5fa60692a46151eb,
+	0x849feec281d7f328, 0xdbc7c41ba6bcd333,
+	0xa5c7ea73224deff3, 0x12b9b522906c0800,
+	0xcf39e50feae16bef, 0xd768226b34870a00,
+	0x81842f29f2cce375, 0xe6a1158300d46640,
+	0xa1e53af46f801c53, 0x60495ae3c1097fd0,
+	0xca5e89b18b602368, 0x385bb19cb14bdfc4,
+	0xfcf62c1dee382c42, 0x46729e03dd9ed7b5,
+	0x9e19db92b4e31ba9, 0x6c07a2c26a8346d1,
+	0xc5a05277621be293, 0xc7098b7305241885,
+	0xf70867153aa2db38, 0xb8cbee4fc66d1ea7,
+};
+
+static const double EXACT_POWERS_OF_TEN[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+struct UInt128
+{
+	uint64_t high;
+	uint64_t low;
+};
+
+static inline UInt128 multiply64(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+	const unsigned __int128 r = (unsigned __int128)a * b;
+	return { (uint64_t)(r >> 64), (uint64_t)r };
+#elif defined(_MSC_VER) && defined(_M_X64)
+	UInt128 r;
+	r.low = _umul128(a, b, &r.high);
+	return r;
+#else
+	const uint64_t aLo = (uint32_t)a, aHi = a >> 32;
+	const uint64_t bLo = (uint32_t)b, bHi = b >> 32;
+	const uint64_t lolo = aLo * bLo, hilo = aHi * bLo, lohi = aLo * bHi, hihi = aHi * bHi;
+	const uint64_t cross = (lolo >> 32) + (uint32_t)hilo + lohi;
+	return { hihi + (hilo >> 32) + (cross >> 32), (cross << 32) | (uint32_t)lolo };
+#endif
+}
+
+static inline int leadingZeros64(uint64_t x)
+{
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return 63 - (int)index;
+#elif defined(_MSC_VER) && !defined(__clang__)
+	int count = 0;
+	while (!(x & (1ull << 63))) { x <<= 1; count++; }
+	return count;
+#else
+	return __builtin_clzll(x);
+#endif
+}
+
+// Eisel-Lemire: the bits of the double nearest to w * 10^q, as in fast_float. Exact for
+// any w that holds all significant digits of the number.
+static uint64_t eiselLemire(uint64_t w, int64_t q)
+{
+	constexpr int MANTISSA_BITS = 52;
+	constexpr uint64_t HIDDEN_BIT = 1ull << MANTISSA_BITS;
+
+	if (w == 0 || q < POWER_OF_FIVE_MIN) return 0;
+	if (q > 308) return 0x7FFull << MANTISSA_BITS;
+
+	const int lz = leadingZeros64(w);
+	w <<= lz;
+
+	// only the high bits matter unless they are all ones, then the low half of
+	// the power can still carry into them
+	const size_t index = 2 * (size_t)(q - POWER_OF_FIVE_MIN);
+	UInt128 product = multiply64(w, POWERS_OF_FIVE[index]);
+	const uint64_t precisionMask = ~0ull >> (MANTISSA_BITS + 3);
+	if ((product.high & precisionMask) == precisionMask)
+	{
+		const UInt128 second = multiply64(w, POWERS_OF_FIVE[index + 1]);
+		product.low += second.high;
+		if (second.high > product.low) product.high++;
+	}
+
+	const int upperBit = (int)(product.high >> 63);
+	const int shift = upperBit + 64 - MANTISSA_BITS - 3;
+	uint64_t mantissa = product.high >> shift;
+	// floor(log2(10^q)) + 63, then rebased on the exponent bias
+	int64_t power2 = (((152170 + 65536) * q) >> 16) + 63 + upperBit - lz + 1023;
+
+	if (power2 <= 0)
+	{
+		// subnormal
+		if (-power2 + 1 >= 64) return 0;
+
+		mantissa >>= -power2 + 1;
+		mantissa += mantissa & 1;
+		mantissa >>= 1;
+		power2 = mantissa < HIDDEN_BIT ? 0 : 1;
+		return (uint64_t)power2 << MANTISSA_BITS | (mantissa & (HIDDEN_BIT - 1));
+	}
+
+	// exactly halfway between two doubles, round to even instead of up
+	if (product.low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == product.high)
+		mantissa &= ~1ull;
+
+	mantissa += mantissa & 1;
+	mantissa >>= 1;
+	if (mantissa >= (HIDDEN_BIT << 1))
+	{
+		mantissa = HIDDEN_BIT;
+		power2++;
+	}
+
+	if (power2 >= 0x7FF) return 0x7FFull << MANTISSA_BITS;
+
+	return (uint64_t)power2 << MANTISSA_BITS | (mantissa & (HIDDEN_BIT - 1));
+}
+
+// Schubfach wants floor(10^k * 2^-r) + 1 for every k, which the table above only holds
+// for k in [-27, -1]
+static inline UInt128 pow10Significand(int k)
+{
+	const size_t index = 2 * (size_t)(k - POWER_OF_FIVE_MIN);
+	UInt128 g = { POWERS_OF_FIVE[index], POWERS_OF_FIVE[index + 1] };
+
+	if (k < -27 || k >= 0)
+	{
+		g.low++;
+		if (g.low == 0) g.high++;
+	}
+
+	return g;
+}
+
+static inline uint64_t roundToOdd(UInt128 g, uint64_t cp)
+{
+	const UInt128 x = multiply64(g.low, cp);
+	const UInt128 y = multiply64(g.high, cp);
+	const uint64_t z = y.low + x.high;
+	const uint64_t carry = z < y.low;
+	return (y.high + carry) | (z > 1);
+}
+
+// Schubfach (Giulietti): the shortest decimal digits * 10^exponent that rounds back to the
+// finite, non zero double made of ieeeSignificand and ieeeExponent
+static uint64_t schubfach(uint64_t ieeeSignificand, uint64_t ieeeExponent, int& exponent)
+{
+	constexpr uint64_t HIDDEN_BIT = 1ull << 52;
+	constexpr int EXPONENT_BIAS = 1023 + 52;
+
+	uint64_t c;
+	int q;
+	if (ieeeExponent != 0)
+	{
+		c = HIDDEN_BIT | ieeeSignificand;
+		q = (int)ieeeExponent - EXPONENT_BIAS;
+	}
+	else
+	{
+		c = ieeeSignificand;
+		q = 1 - EXPONENT_BIAS;
+	}
+
+	const bool acceptBounds = c % 2 == 0;
+	const bool lowerBoundaryIsCloser = ieeeSignificand == 0 && ieeeExponent > 1;
+
+	const uint64_t cbl = 4 * c - 2 + lowerBoundaryIsCloser;
+	const uint64_t cb = 4 * c;
+	const uint64_t cbr = 4 * c + 2;
+
+	// floor(log10(3/4 * 2^q)) and floor(log10(2^q)), then h = q + floor(log2(10^-k)) + 1
+	const int k = lowerBoundaryIsCloser ? (q * 1262611 - 524031) >> 22 : (q * 1262611) >> 22;
+	const int h = q + ((-k * 1741647) >> 19) + 1;
+
+	const UInt128 pow10 = pow10Significand(-k);
+	const uint64_t vbl = roundToOdd(pow10, cbl << h);
+	const uint64_t vb = roundToOdd(pow10, cb << h);
+	const uint64_t vbr = roundToOdd(pow10, cbr << h);
+
+	const uint64_t lower = vbl + !acceptBounds;
+	const uint64_t upper = vbr - !acceptBounds;
+
+	uint64_t digits;
+	const uint64_t s = vb / 4;
+
+	// try one digit less first
+	if (s >= 10)
+	{
+		const uint64_t sp = s / 10;
+		const bool upInside = lower <= 40 * sp;
+		const bool wpInside = 40 * sp + 40 <= upper;
+		if (upInside != wpInside)
+		{
+			exponent = k + 1;
+			return sp + wpInside;
+		}
+	}
+
+	const bool uInside = lower <= 4 * s;
+	const bool wInside = 4 * s + 4 <= upper;
+	if (uInside != wInside)
+	{
+		digits = s + wInside;
+	}
+	else
+	{
+		const uint64_t mid = 4 * s + 2;
+		const bool roundUp = vb > mid || (vb == mid && (s & 1) != 0);
+		digits = s + roundUp;
+	}
+
+	exponent = k;
+	return digits;
+}
+
+static inline int decimalLength(uint64_t value)
+{
+	int length = 1;
+	while (value >= 10)
+	{
+		value /= 10;
+		length++;
+	}
+
+	return length;
+}
+
+// Shortest round trip representation of value, out needs room for 32 characters.
+// Integral values print as integers, the rest like JavaScript does: plain notation
+// between 1e-6 and 1e21, exponent notation outside of it.
+static size_t formatDouble(double value, char* out)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	const uint64_t ieeeSignificand = bits & ((1ull << 52) - 1);
+	const uint64_t ieeeExponent = (bits >> 52) & 0x7FF;
+
+	// JSON has no NaN or infinity
+	if (ieeeExponent == 0x7FF)
+	{
+		memcpy(out, "null", 4);
+		return 4;
+	}
+
+	char* at = out;
+	if (bits >> 63) *at++ = '-';
+
+	const double magnitude = (bits >> 63) ? -value : value;
+	if (magnitude < 9007199254740992.0 && magnitude == (double)(uint64_t)magnitude)
+	{
+		char digits[20];
+		char* const end = digits + sizeof(digits);
+		char* const begin = formatDigits((uint64_t)magnitude, end);
+		memcpy(at, begin, end - begin);
+		return at + (end - begin) - out;
+	}
+
+	int exponent;
+	uint64_t digits = schubfach(ieeeSignificand, ieeeExponent, exponent);
+	while (digits % 10 == 0)
+	{
+		digits /= 10;
+		exponent++;
+	}
+
+	const int length = decimalLength(digits);
+	// position of the decimal point relative to the first digit
+	const int point = exponent + length;
+
+	if (length <= point && point <= 21)
+	{
+		formatDigits(digits, at + length);
+		at += length;
+		memset(at, '0', point - length);
+		at += point - length;
+	}
+	else if (0 < point && point <= 21)
+	{
+		formatDigits(digits, at + length + 1);
+		memmove(at, at + 1, point);
+		at[point] = '.';
+		at += length + 1;
+	}
+	else if (-6 < point && point <= 0)
+	{
+		at[0] = '0';
+		at[1] = '.';
+		memset(at + 2, '0', -point);
+		at += 2 - point;
+		formatDigits(digits, at + length);
+		at += length;
+	}
+	else
+	{
+		// d[.ddd]e[-]x
+		formatDigits(digits, at + length + 1);
+		at[0] = at[1];
+		if (length > 1)
+		{
+			at[1] = '.';
+			at += length + 1;
+		}
+		else
+		{
+			at++;
+		}
+
+		*at++ = 'e';
+		int e = point - 1;
+		if (e < 0)
+		{
+			*at++ = '-';
+			e = -e;
+		}
+
+		char* const end = at + decimalLength((uint64_t)e);
+		formatDigits((uint64_t)e, end);
+		at = end;
+	}
+
+	return at - out;
+}
+
+static double parseNumberFallback(const char* str, int length)
+{
+	// more than 19 significant digits, rare enough to leave to the C library. strtod
+	// follows the locale, so the decimal point is swapped for the one it expects
+	std::string copy(str, length);
+	std::replace(copy.begin(), copy.end(), '.', *localeconv()->decimal_point);
+	return strtod(copy.c_str(), nullptr);
+}
+
+// returns true when the number is an integer that fits in 64 bits, which is stored in
+// integer instead of num
+static bool parseNumber(const char* str, int length, double& num, int64_t& integer)
+{
+	const char* at = str;
+	const char* end = str + length;
+	const bool negative = *at == '-';
+	if (negative) at++;
+
+	uint64_t mantissa = 0;
+	int64_t exponent = 0;
+	int digits = 0;
+	bool isInteger = true;
+
+	const char* start = at;
+	while (at < end && isDigit(*at))
+		mantissa = mantissa * 10 + (uint64_t)(*at++ - '0');
+	digits = (int)(at - start);
+
+	if (at < end && *at == '.')
+	{
+		isInteger = false;
+		const char* fraction = ++at;
+		while (at < end && isDigit(*at))
+			mantissa = mantissa * 10 + (uint64_t)(*at++ - '0');
+		exponent = -(int64_t)(at - fraction);
+		digits += (int)(at - fraction);
+	}
+
+	if (at < end)
+	{
+		// 'e' or 'E'
+		isInteger = false;
+		at++;
+		const bool negativeExponent = at < end && *at == '-';
+		if (at < end && (*at == '-' || *at == '+')) at++;
+
+		int64_t value = 0;
+		while (at < end)
+		{
+			// anything this large is zero or infinity already
+			if (value < 0x10000000) value = value * 10 + (*at - '0');
+			at++;
+		}
+		exponent += negativeExponent ? -value : value;
+	}
+
+	if (digits > 19)
+	{
+		// leading zeros are not significant and did not overflow the mantissa
+		for (const char* p = start; p < end && (*p == '0' || *p == '.'); p++)
+			if (*p == '0') digits--;
+
+		if (digits > 19)
+		{
+			num = parseNumberFallback(str, length);
+			return false;
+		}
+	}
+
+	// negative integers reach one further than positive ones, and -0 stays a double
+	if (isInteger && (negative ? mantissa - 1 <= (uint64_t)INT64_MAX : mantissa <= (uint64_t)INT64_MAX))
+	{
+		integer = negative ? (int64_t)(0 - mantissa) : (int64_t)mantissa;
+		return true;
+	}
+
+	double result;
+
+	if (isInteger)
+	{
+		// the conversion itself rounds correctly
+		result = (double)mantissa;
+	}
+	else if (exponent >= -22 && exponent <= 22 && mantissa <= (1ull << 53))
+	{
+		// both operands are exact, so a single rounding step is too (Clinger)
+		result = (double)mantissa;
+		result = exponent < 0 ? result / EXACT_POWERS_OF_TEN[-exponent] : result * EXACT_POWERS_OF_TEN[exponent];
+	}
+	else
+	{
+		const uint64_t bits = eiselLemire(mantissa, exponent);
+		memcpy(&result, &bits, sizeof(result));
+	}
+
+	num = negative ? -result : result;
+	return false;
+}
+
+struct JsonVal
+{
+	pj_ValueType type;
+
+	union
+	{
+		double num;
+		int64_t int64;
+		bool boolean;
+		char* string;
+		pj_Array* array;
+		pj_Object* obj;
+		struct SourceSpan* lazy;
+	};
+
+	// set when the payload belongs to a document arena rather than to this value
+	bool isBorrowed = false;
+	// an object or array of a PJ_PARSE_LAZY document that was not parsed yet, see materializeValue
+	bool isLazy = false;
+
+	JsonVal() = default;
+	JsonVal(const JsonVal& other) = delete;
+	JsonVal operator=(JsonVal& other) = delete;
+
+	JsonVal& operator=(JsonVal&& other)
+	{
+		if (this != &other)
+		{
+			free();
+			type = other.type;
+			isBorrowed = other.isBorrowed;
+			isLazy = other.isLazy;
+			move(std::forward<JsonVal>(other));
+		}
+
+		return *this;
+	}
+
+	JsonVal(JsonVal&& other) :
+		type(other.type),
+		isBorrowed(other.isBorrowed),
+		isLazy(other.isLazy)
+	{
+		move(std::forward<JsonVal>(other));
+	}
+
+	~JsonVal()
+	{
+		free();
+	}
+
+private:
+
+	void free()
+	{
+		if (isBorrowed) return;
+
+		switch (type)
+		{
+		case PJ_VALUE_STRING:
+			delete[] string;
+			string = nullptr;
+			break;
+		case PJ_VALUE_ARRAY:
+			pj_deleteArray(array);
+			array = nullptr;
+			break;
+		case PJ_VALUE_OBJ:
+			pj_deleteObj(obj);
+			obj = nullptr;
+			break;
+		default:
+			break;
+		}
+	}
+
+	void move(JsonVal&& other)
+	{
+		switch (other.type)
+		{
+		case PJ_VALUE_NUMBER: num = other.num; break;
+		case PJ_VALUE_INT64: int64 = other.int64; break;
+		case PJ_VALUE_STRING:
+			string = other.string;
+			other.string = nullptr;
+			break;
+		case PJ_VALUE_BOOL: boolean = other.boolean; break;
+		case PJ_VALUE_OBJ:
+			obj = other.obj;
+			other.obj = nullptr;
+			break;
+		case PJ_VALUE_ARRAY:
+			array = other.array;
+			other.array = nullptr;
+			break;
+		default:
+			break;
+		}
+	}
+};
+
+struct JsonProp
+{
+	JsonVal val;
+};
+
+static void unmapInputFile(void* mapping, size_t size);
+
+// Backs every node, key and string of a document parsed with PJ_PARSE_ARENA.
+// Nothing inside is freed on its own; deleting the root releases all blocks at once.
+struct Arena
+{
+	std::pmr::monotonic_buffer_resource resource{ ARENA_BLOCK_SIZE };
+	void* root = nullptr;
+
+	// heap nodes attached to the document through pj_objSet*/pj_arrayAdd*, freed along with it
+	std::vector<pj_Object*> adoptedObjects;
+	std::vector<pj_Array*> adoptedArrays;
+	// the arenas of the other chunks of an array parsed in parallel, see pj_parseArrayParallel
+	std::vector<Arena*> adoptedArenas;
+
+	// the file a document was parsed from in place, see pj_parseObjFile
+	void* mapping = nullptr;
+	size_t mappingSize = 0;
+
+	// the nodes of the document remember their input text, see PJ_PARSE_KEEP_SOURCE. cleared
+	// when the document turned out to be invalid
+	bool keepSource = false;
+	// deferred values are parsed, into this arena, as they are reached, see PJ_PARSE_LAZY
+	bool lazy = false;
+
+	// Key dictionary of PJ_PARSE_INTERN_KEYS, an open addressing table (power of two, at most
+	// half full) of every distinct key in the document. Objects of the document only ever
+	// hold keys from here, see internKey
+	bool internKeys = false;
+	std::vector<const char*> keySlots;
+	size_t keyCount = 0;
+
+	~Arena()
+	{
+		for (pj_Object* obj : adoptedObjects) pj_deleteObj(obj);
+		for (pj_Array* array : adoptedArrays) pj_deleteArray(array);
+		for (Arena* arena : adoptedArenas) delete arena;
+
+		if (mapping) unmapInputFile(mapping, mappingSize);
+	}
+
+	template<typename T, typename... Args>
+	T* create(Args&&... args)
+	{
+		void* mem = resource.allocate(sizeof(T), alignof(T));
+		return new (mem) T(std::forward<Args>(args)...);
+	}
+};
+
+// The input text of an object or array, from its opening bracket to one past its closing
+// one. Deferred values are parsed from it and unmodified nodes serialized from it. The spans
+// of a document form a tree like its nodes do, so a change can be propagated upwards
+struct SourceSpan
+{
+	const char* at;
+	const char* end;
+	size_t lineNo;
+	Arena* arena;
+	SourceSpan* parent;
+	// set once the node or anything below it was modified, see markModified
+	bool isModified;
+};
+
+static std::pmr::memory_resource* resourceOf(Arena* arena)
+{
+	return arena ? &arena->resource : std::pmr::new_delete_resource();
+}
+
+struct pj_Array
+{
+	JsonVal* items;
+	size_t size;
+	size_t capacity;
+	Arena* arena;
+	SourceSpan* source;
+};
+
+// keys are NUL-terminated and owned by the object, unless the object lives in an arena
+struct ObjectEntry
+{
+	const char* key;
+	uint32_t keyLength;
+	// only set once the object has an index
+	uint32_t hash;
+	JsonProp prop;
+};
+
+struct pj_Object
+{
+	Arena* arena;
+
+	// members in insertion order, raw storage of which only [0, size) is constructed
+	ObjectEntry* entries = nullptr;
+	uint32_t size = 0;
+	uint32_t capacity = 0;
+
+	// Up to SMALL_OBJECT_SIZE members are found with a linear scan. Larger objects get an
+	// open addressing index of indexCapacity slots (a power of two, at most half full)
+	// probed linearly, each holding the position of an entry plus one, or 0 when empty
+	uint32_t* index = nullptr;
+	uint32_t indexCapacity = 0;
+
+	SourceSpan* source = nullptr;
+
+	pj_Object(Arena* arena) :
+		arena(arena)
+	{ }
+
+	~pj_Object()
+	{
+		if (arena) return;
+
+		for (uint32_t i = 0; i < size; i++)
+		{
+			delete[] entries[i].key;
+			entries[i].prop.~JsonProp();
+		}
+
+		std::pmr::memory_resource* resource = resourceOf(arena);
+		if (entries) resource->deallocate(entries, capacity * sizeof(ObjectEntry), alignof(ObjectEntry));
+		if (index) resource->deallocate(index, indexCapacity * sizeof(uint32_t), alignof(uint32_t));
+	}
+};
+
+// Interned keys are stored right behind their hash and length, so both come with the pointer
+struct InternedKey
+{
+	uint32_t hash;
+	uint32_t length;
+};
+
+static inline const InternedKey& internedHeader(const char* key)
+{
+	return ((const InternedKey*)key)[-1];
+}
+
+static inline bool internsKeys(const pj_Object& obj)
+{
+	return obj.arena && obj.arena->internKeys;
+}
+
+// visits the members of obj in insertion order
+template<typename F>
+static void forEachEntry(pj_Object& obj, F&& visit)
+{
+	for (uint32_t i = 0; i < obj.size; i++)
+		visit(obj.entries[i]);
+}
+
+static std::atomic<int> parseEngine{ PJ_ENGINE_RECURSIVE };
+
+struct ParseContext
+{
+	Arena* arena = nullptr;
+
+	// strings are decoded in place and point into the input buffer
+	bool inSitu = false;
+	// nested objects and arrays are skipped and recorded, see PJ_PARSE_LAZY
+	bool lazy = false;
+	// the span of the object or array being parsed, parent of the spans opened below it
+	SourceSpan* span = nullptr;
+
+	// the interned key last seen at each member position, records of the same shape
+	// find theirs here without hashing
+	const char* recentKeys[SMALL_OBJECT_SIZE] = {};
+};
+
+struct pj_Builder
+{
+	struct Scope
+	{
+		bool isObject;
+		size_t count;
+	};
+
+	Writer out;
+	pj_boolean isPretty;
+	std::vector<Scope> scopes;
+
+	// the key of an object member was written, its value comes next
+	bool hasKey = false;
+	bool done = false;
+	bool misused = false;
+
+	pj_Builder(pj_boolean isPretty, pj_WriteCallback callback, void* userData) :
+		out(callback, userData),
+		isPretty(isPretty)
+	{
+	}
+};
+
+struct pj_SaxParser
+{
+	// what the next token may be
+	enum State
+	{
+		VALUE,
+		VALUE_OR_END,
+		KEY,
+		KEY_OR_END,
+		COLON,
+		COMMA_OR_END,
+		DONE
+	};
+
+	pj_SaxCallbacks callbacks;
+	void* userData;
+
+	// input that was not consumed yet, starting with the token cut off by the end of the
+	// last chunk, and a terminator
+	std::vector<char> buffer;
+	size_t start = 0;
+
+	// how far a cut off string was already scanned
+	size_t resume = 0;
+	bool resumeHasEscapes = false;
+
+	// true for objects
+	std::vector<bool> scopes;
+	State state = VALUE;
+	size_t lineNo = 0;
+	bool failed = false;
+};
+
+struct pj_Path
+{
+	struct Segment
+	{
+		const char* key;
+		uint32_t keyLength;
+		uint32_t hash;
+		// NO_INDEX unless the segment is a valid array index
+		size_t index;
+	};
+
+	static constexpr size_t NO_INDEX = SIZE_MAX;
+
+	std::vector<Segment> segments;
+	// decoded segment keys back to back, each NUL terminated
+	std::string keys;
+};
+
+struct pj_Extractor
+{
+	// the fields sharing a path prefix share the nodes along it
+	struct Node
+	{
+		// null for the root
+		const pj_Path::Segment* segment;
+		std::vector<uint32_t> children;
+		std::vector<uint32_t> fields;
+	};
+
+	std::vector<pj_Field> fields;
+	// one per field, never resized once compiled since the nodes point into them
+	std::vector<pj_Path> paths;
+	std::vector<Node> nodes;
+};
+
+// a line of NDJSON input and what it parsed into
+struct NdjsonRecord
+{
+	const char* at;
+	size_t length;
+	size_t lineNo;
+
+	pj_Object* obj;
+	pj_Array* array;
+	// the errors the record raised on a worker thread, most recent first
+	std::vector<std::string> errors;
+};
+
+// a run of top level elements of an array parsed in parallel, and the array they parsed into
+struct ArrayChunk
+{
+	const char* at;
+	size_t length;
+	size_t lineNo;
+
+	pj_Array* array;
+	// the errors the chunk raised on a worker thread, most recent first
+	std::vector<std::string> errors;
+};
+
+// A run of the output of a parallel serialization, text written by the calling thread or,
+// when array or obj is set, the members [begin, end) of it formatted by a worker
+struct OutputPiece
+{
+	Writer out;
+
+	pj_Array* array = nullptr;
+	pj_Object* obj = nullptr;
+	size_t begin = 0;
+	size_t end = 0;
+	int depth = 0;
+};
+
+// what is left of the tasks of one thread in runParallel, others steal from its back
+struct WorkRange
+{
+	std::mutex lock;
+	size_t begin;
+	size_t end;
+};
+
+static pj_Object* createObj(Arena* arena);
+static pj_Array* createArray(Arena* arena);
+static void adoptValue(Arena* arena, JsonVal& val);
+static char* parseCString(ParseContext& ctx, const Token& token, size_t* outLength);
+static char* parseKeyString(ParseContext& ctx, const Token& token, uint32_t position, size_t* outLength);
+static void setObjectValue(pj_Object* obj, const char* propName, JsonVal&& val);
+static void appendArrayValue(pj_Array* array, JsonVal&& val);
+
+static void parseJSONObject(ParseContext& ctx, Cursor& cursor, pj_Object* json);
+static void parseJSONArray(ParseContext& ctx, Cursor& cursor, pj_Array* array);
+static bool parseJSONValue(ParseContext& ctx, Cursor& cursor, Token& valueToken, JsonVal& val);
+static Token indexedToken(IndexCursor& cursor);
+static size_t indexedLineNo(const IndexCursor& cursor);
+static const char* indexedEnd(const IndexCursor& cursor);
+static void parseIndexedObject(ParseContext& ctx, IndexCursor& cursor, pj_Object* json);
+static void parseIndexedArray(ParseContext& ctx, IndexCursor& cursor, pj_Array* array);
+static bool parseIndexedValue(ParseContext& ctx, IndexCursor& cursor, Token& valueToken, JsonVal& val);
+static bool parseScalarValue(ParseContext& ctx, const Token& valueToken, JsonVal& val);
+static bool deferValue(ParseContext& ctx, Cursor& cursor, const Token& valueToken, JsonVal& val);
+static void materializeValue(JsonVal& val);
+static const char* skipContainer(const char* at, const char* end);
+static const char* findRecordEnd(const char* at, const char* end);
+static const char* splitRecords(const char* at, const char* end, size_t& lineNo, std::vector<NdjsonRecord>& records);
+static void parseRecord(NdjsonRecord& record, unsigned int flags);
+static size_t parseNdjson(const char* data, size_t length, unsigned int flags, unsigned int threadCount, pj_RecordCallback callback, void* userData);
+static void takeErrors(size_t pushed, std::vector<std::string>& taken);
+static void pushTakenErrors(const std::vector<std::string>& taken, const char* area, const char* place, size_t lineNo);
+static bool splitArrayChunks(const char* at, const char* end, size_t lineNo, std::vector<ArrayChunk>& chunks);
+static void parseArrayChunk(ArrayChunk& chunk, unsigned int flags);
+static pj_Array* parseArrayParallel(const char* raw, size_t length, unsigned int flags, unsigned int threadCount);
+static bool takeTask(WorkRange& range, size_t& task);
+static bool stealTasks(WorkRange* ranges, unsigned int threadCount, unsigned int self);
+static SourceSpan* createSourceSpan(ParseContext& ctx, const char* at, size_t lineNo);
+static SourceSpan* beginSourceSpan(ParseContext& ctx, const char* at);
+static void endSourceSpan(ParseContext& ctx, SourceSpan* span, const char* end);
+static void markModified(SourceSpan* span);
+static bool writeSource(Writer& out, const SourceSpan* span);
+static void addParsedProp(ParseContext& ctx, pj_Object* json, char* name, size_t nameLength, JsonProp&& prop);
+static void objectToString(Writer& out, pj_Object* obj, int depth, pj_boolean isPretty);
+static void arrayToString(Writer& out, pj_Array* array, int depth, pj_boolean isPretty);
+static void valueToString(Writer& out, JsonVal& val, int depth, pj_boolean isPretty);
+static void writeObjectEntries(Writer& out, pj_Object* obj, size_t begin, size_t end, int depth, pj_boolean isPretty);
+static void writeArrayItems(Writer& out, pj_Array* array, size_t begin, size_t end, int depth, pj_boolean isPretty);
+static bool canSplitOutput(Arena* arena, size_t size, pj_boolean isPretty);
+static void splitOutput(std::deque<OutputPiece>& pieces, pj_Object* obj, pj_Array* array, size_t size, int depth);
+static void planObjectOutput(std::deque<OutputPiece>& pieces, pj_Object* obj, int depth, pj_boolean isPretty);
+static void planArrayOutput(std::deque<OutputPiece>& pieces, pj_Array* array, int depth, pj_boolean isPretty);
+static void planValueOutput(std::deque<OutputPiece>& pieces, JsonVal& val, int depth, pj_boolean isPretty);
+static void serializeParallel(std::deque<OutputPiece>& pieces, pj_Object* obj, pj_Array* array, pj_boolean isPretty, unsigned int threadCount);
+static char* joinOutput(std::deque<OutputPiece>& pieces, size_t* outLength);
+static bool writeOutput(std::deque<OutputPiece>& pieces, int fd);
+static FILE* openForWriting(const char* fileName);
+static char* mapInputFile(Arena& arena, const char* fileName, size_t& length);
+static char* readInputFile(Arena& arena, const char* fileName, size_t& length);
+static size_t streamSink(void* file, const char* data, size_t length);
+static size_t fdSink(void* fd, const char* data, size_t length);
+
+static void builderError(pj_Builder& builder, const char* message);
+static void builderSeparate(pj_Builder& builder);
+static bool beginBuilderValue(pj_Builder& builder);
+static void endBuilderValue(pj_Builder& builder);
+static void endBuilderScope(pj_Builder& builder, bool isObject);
+
+static void saxError(pj_SaxParser& parser, const char* message);
+static void appendSaxInput(pj_SaxParser& parser, const char* data, size_t length);
+static void runSaxParser(pj_SaxParser& parser, bool isFinal);
+static bool nextSaxToken(pj_SaxParser& parser, char* at, bool isFinal, Token& token);
+static void handleSaxToken(pj_SaxParser& parser, Token& token);
+static void saxValue(pj_SaxParser& parser, Token& token);
+static void endSaxValue(pj_SaxParser& parser);
+
+static void addArrayValue(pj_Array& array, struct JsonVal&& val);
+static void reserveArray(pj_Array& array, size_t capacity);
+static void reallocateArray(pj_Array& array, size_t capacity);
+static size_t countArrayElements(const char* at, const char* end);
+
+static struct JsonProp* findProp(pj_Object& obj, const char* propName);
+static ObjectEntry* findEntry(pj_Object& obj, const char* key, size_t keyLength);
+static ObjectEntry* findEntry(pj_Object& obj, const char* key, size_t keyLength, uint32_t hash);
+static ObjectEntry* findInternedEntry(pj_Object& obj, const char* key);
+static ObjectEntry& insertEntry(pj_Object& obj, const char* key, size_t keyLength);
+static void reallocateEntries(pj_Object& obj, uint32_t capacity);
+static void rebuildObjectIndex(pj_Object& obj, uint32_t indexCapacity);
+static void indexEntry(pj_Object& obj, uint32_t position);
+static uint32_t hashKey(const char* key, size_t length);
+static bool compilePath(pj_Path& path, const char* str);
+static JsonVal* findPathValue(pj_Object* obj, pj_Array* array, const pj_Path& path);
+static JsonVal* findSegmentValue(pj_Object* obj, pj_Array* array, const pj_Path::Segment& segment);
+static bool compileExtractor(pj_Extractor& extractor, const pj_Field* fields, size_t count);
+static size_t extractNode(const pj_Extractor& extractor, const pj_Extractor::Node& node, JsonVal* val, char* out);
+static bool storeField(const pj_Field& field, JsonVal* val, char* out);
+static uint32_t entryHash(const pj_Object& obj, const char* key, size_t keyLength);
+static const char* internKey(Arena& arena, const char* key, size_t length);
+static const char* findInternedKey(const Arena& arena, const char* key, size_t length, uint32_t hash);
+
+// the two number representations convert into each other, so each matches both
+static bool isValueOfType(const JsonVal& val, pj_ValueType type)
+{
+	const auto isNumber = [](pj_ValueType t) { return t == PJ_VALUE_NUMBER || t == PJ_VALUE_INT64; };
+	if (isNumber(type)) return isNumber(val.type);
+
+	return val.type == type;
+}
+
+template <typename T, pj_ValueType valType>
+T getValueOfType(JsonVal& val, T failVal)
+{
+	if constexpr (valType == PJ_VALUE_OBJ || valType == PJ_VALUE_ARRAY)
+		materializeValue(val);
+
+	if constexpr (valType == PJ_VALUE_NUMBER)
+	{
+		if (val.type == PJ_VALUE_INT64) return (double)val.int64;
+	}
+	else if constexpr (valType == PJ_VALUE_INT64)
+	{
+		if (val.type == PJ_VALUE_NUMBER)
+		{
+			// out of range doubles have no integer value
+			if (!(val.num >= -9223372036854775808.0 && val.num < 9223372036854775808.0)) return failVal;
+			return (int64_t)val.num;
+		}
+	}
+
+	if (val.type != valType) return failVal;
+
+	if constexpr (valType == PJ_VALUE_NUMBER)
+		return val.num;
+	else if constexpr (valType == PJ_VALUE_INT64)
+		return val.int64;
+	else if constexpr (valType == PJ_VALUE_STRING)
+		return val.string;
+	else if constexpr (valType == PJ_VALUE_BOOL)
+		return val.boolean;
+	else if constexpr (valType == PJ_VALUE_OBJ)
+		return val.obj;
+	else if constexpr (valType == PJ_VALUE_ARRAY)
+		return val.array;
+	else if constexpr (valType == PJ_VALUE_NULL)
+		return failVal;
+}
+
+template<typename T, pj_ValueType valType>
+T getObjectValue(pj_Object* json, const char* propName, T failVal = 0)
+{
+	// the segments of a dotted name are looked up where they are, without copying them
+	for (const char* dot = strchr(propName, '.'); dot; dot = strchr(propName, '.'))
+	{
+		ObjectEntry* entry = findEntry(*json, propName, dot - propName);
+		assert(entry && entry->prop.val.type == PJ_VALUE_OBJ);
+		if (!entry || entry->prop.val.type != PJ_VALUE_OBJ) return failVal;
+
+		materializeValue(entry->prop.val);
+		json = entry->prop.val.obj;
+		propName = dot + 1;
+	}
+
+	if (JsonProp* prop = findProp(*json, propName))
+	{
+		if (prop->val.type == PJ_VALUE_NULL) return failVal;
+
+		assert(isValueOfType(prop->val, valType));
+
+		return getValueOfType<T, valType>(prop->val, failVal);
+	}
+
+	return failVal;
+}
+
+template<typename T, pj_ValueType valType>
+T getPathValue(pj_Object* obj, pj_Array* array, const pj_Path* path, T failVal = 0)
+{
+	JsonVal* val = findPathValue(obj, array, *path);
+	if (!val || val->type == PJ_VALUE_NULL) return failVal;
+
+	assert(isValueOfType(*val, valType));
+
+	return getValueOfType<T, valType>(*val, failVal);
+}
+
+// unlike the getters a mismatched type is no error, extracted documents are untrusted
+template<typename T, pj_ValueType valType>
+bool storeValue(void* slot, JsonVal* val)
+{
+	const bool matches = val && isValueOfType(*val, valType);
+	*(T*)slot = matches ? getValueOfType<T, valType>(*val, T()) : T();
+	return matches;
+}
+
+// Runs task(i) for every i in [0, taskCount) on up to threadCount threads, the calling one
+// included, and returns once all of them are done. Each thread starts on an even share of
+// the tasks and steals half of what another one has left when it runs out
+template<typename Task>
+void runParallel(size_t taskCount, unsigned int threadCount, const Task& task)
+{
+	if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+	if (threadCount > taskCount) threadCount = (unsigned int)taskCount;
+
+	if (threadCount <= 1)
+	{
+		for (size_t i = 0; i < taskCount; i++) task(i);
+		return;
+	}
+
+	std::unique_ptr<WorkRange[]> ranges(new WorkRange[threadCount]);
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		ranges[i].begin = taskCount * i / threadCount;
+		ranges[i].end = taskCount * (i + 1) / threadCount;
+	}
+
+	const auto work = [&](unsigned int self)
+	{
+		size_t index;
+		for (;;)
+		{
+			if (takeTask(ranges[self], index))
+				task(index);
+			else if (!stealTasks(ranges.get(), threadCount, self))
+				return;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < threadCount; i++) threads.emplace_back(work, i);
+
+	work(0);
+
+	for (std::thread& thread : threads) thread.join();
+}
+
+template<typename T, pj_ValueType valType>
+T getArrayValue(pj_Array* array, size_t index, T failVal = 0)
+{
+	assert(index >= 0 && index < array->size);
+
+	JsonVal& val = array->items[index];
+
+	if (val.type == PJ_VALUE_NULL) return failVal;
+
+	assert(isValueOfType(val, valType));
+
+	return getValueOfType<T, valType>(val, failVal);
+}
+
+EXTERN_C pj_Object * pj_parseObj(const char * raw)
+{
+	return pj_parseObjEx(raw, PJ_PARSE_DEFAULT);
+}
+
+EXTERN_C pj_Array * pj_parseArray(const char * raw)
+{
+	return pj_parseArrayEx(raw, PJ_PARSE_DEFAULT);
+}
+
+// Runs stage one when PJ_ENGINE_STRUCTURAL_INDEX is selected. Offsets are 32 bit,
+// larger inputs stay on the recursive engine.
+static bool openIndexedCursor(const char* raw, size_t length, std::vector<uint32_t>& index, IndexCursor& cursor)
+{
+	if (parseEngine.load(std::memory_order_relaxed) != PJ_ENGINE_STRUCTURAL_INDEX) return false;
+
+	if (length > UINT32_MAX) return false;
+
+	buildStructuralIndex(raw, length, index);
+	cursor = { raw, raw + length, index.data(), index.data() + index.size() };
+	return true;
+}
+
+// the input text of a document that had errors cannot stand in for any part of it
+static void checkKeptSource(ParseContext& ctx, size_t pushed)
+{
+	if (ctx.arena && errors.pushed != pushed) ctx.arena->keepSource = false;
+}
+
+static pj_Object* parseRootObj(ParseContext& ctx, const char* raw, size_t length)
+{
+	pj_Object* json = createObj(ctx.arena);
+	if (ctx.arena) ctx.arena->root = json;
+
+	const size_t pushed = errors.pushed;
+
+	std::vector<uint32_t> index;
+	IndexCursor ic;
+	if (!ctx.lazy && openIndexedCursor(raw, length, index, ic))
+	{
+		const Token t = indexedToken(ic);
+		if (t.type == Token::OPEN_BRACE)
+		{
+			json->source = beginSourceSpan(ctx, t.str);
+			parseIndexedObject(ctx, ic, json);
+			endSourceSpan(ctx, json->source, indexedEnd(ic));
+			checkKeptSource(ctx, pushed);
+			return json;
+		}
+
+		pj_deleteObj(json);
+		return nullptr;
+	}
+
+	Cursor c = { raw, raw + length };
+
+	const Token t = getToken(c);
+	if (t.type == Token::OPEN_BRACE)
+	{
+		json->source = beginSourceSpan(ctx, t.str);
+		parseJSONObject(ctx, c, json);
+		endSourceSpan(ctx, json->source, c.at);
+		checkKeptSource(ctx, pushed);
+		return json;
+	}
+	else
+	{
+		pj_deleteObj(json);
+		return nullptr;
+	}
+}
+
+static pj_Array* parseRootArray(ParseContext& ctx, const char* raw, size_t length)
+{
+	pj_Array* array = createArray(ctx.arena);
+	if (ctx.arena) ctx.arena->root = array;
+
+	const size_t pushed = errors.pushed;
+
+	std::vector<uint32_t> index;
+	IndexCursor ic;
+	if (!ctx.lazy && openIndexedCursor(raw, length, index, ic))
+	{
+		const Token t = indexedToken(ic);
+		if (t.type == Token::SQUARE_BRACKET_OPEN)
+		{
+			array->source = beginSourceSpan(ctx, t.str);
+			parseIndexedArray(ctx, ic, array);
+			endSourceSpan(ctx, array->source, indexedEnd(ic));
+			checkKeptSource(ctx, pushed);
+			return array;
+		}
+
+		pj_deleteArray(array);
+		return nullptr;
+	}
+
+	Cursor c = { raw, raw + length };
+
+	const Token t = getToken(c);
+	if (t.type == Token::SQUARE_BRACKET_OPEN)
+	{
+		array->source = beginSourceSpan(ctx, t.str);
+		parseJSONArray(ctx, c, array);
+		endSourceSpan(ctx, array->source, c.at);
+		checkKeptSource(ctx, pushed);
+		return array;
+	}
+	else
+	{
+		pj_deleteArray(array);
+		return nullptr;
+	}
+}
+
+static const char* openParseContext(ParseContext& ctx, const char* raw, size_t length, unsigned int flags)
+{
+	if (flags & (PJ_PARSE_ARENA | PJ_PARSE_INTERN_KEYS | PJ_PARSE_LAZY | PJ_PARSE_KEEP_SOURCE)) ctx.arena = new Arena();
+	if (flags & PJ_PARSE_INTERN_KEYS) ctx.arena->internKeys = true;
+	if (!(flags & (PJ_PARSE_LAZY | PJ_PARSE_KEEP_SOURCE))) return raw;
+
+	// deferred values and unmodified nodes refer to the document's own copy of the input,
+	// which is therefore never decoded in place
+	char* copy = (char*)ctx.arena->resource.allocate(length + 1, 1);
+	memcpy(copy, raw, length);
+	copy[length] = 0;
+
+	ctx.arena->keepSource = true;
+	ctx.arena->lazy = ctx.lazy = (flags & PJ_PARSE_LAZY) != 0;
+	return copy;
+}
+
+EXTERN_C pj_Object * pj_parseObjEx(const char * raw, unsigned int flags)
+{
+	ParseContext ctx = {};
+	const size_t length = strlen(raw);
+
+	return parseRootObj(ctx, openParseContext(ctx, raw, length, flags), length);
+}
+
+EXTERN_C pj_Array * pj_parseArrayEx(const char * raw, unsigned int flags)
+{
+	ParseContext ctx = {};
+	const size_t length = strlen(raw);
+
+	return parseRootArray(ctx, openParseContext(ctx, raw, length, flags), length);
+}
+
+EXTERN_C pj_Object * pj_parseObjInSitu(char * raw)
+{
+	ParseContext ctx = {};
+	ctx.arena = new Arena();
+	ctx.inSitu = true;
+
+	return parseRootObj(ctx, raw, strlen(raw));
+}
+
+EXTERN_C pj_Array * pj_parseArrayInSitu(char * raw)
+{
+	ParseContext ctx = {};
+	ctx.arena = new Arena();
+	ctx.inSitu = true;
+
+	return parseRootArray(ctx, raw, strlen(raw));
+}
+
+EXTERN_C pj_Object * pj_parseObjN(const char * raw, size_t length)
+{
+	ParseContext ctx = {};
+	return parseRootObj(ctx, raw, length);
+}
+
+EXTERN_C pj_Array * pj_parseArrayN(const char * raw, size_t length)
+{
+	ParseContext ctx = {};
+	return parseRootArray(ctx, raw, length);
+}
+
+EXTERN_C pj_Object * pj_parseObjFile(const char * fileName)
+{
+	ParseContext ctx = {};
+	ctx.arena = new Arena();
+	ctx.inSitu = true;
+
+	size_t length = 0;
+	char* raw = mapInputFile(*ctx.arena, fileName, length);
+	if (!raw)
+	{
+		delete ctx.arena;
+		return nullptr;
+	}
+
+	return parseRootObj(ctx, raw, length);
+}
+
+EXTERN_C pj_Array * pj_parseArrayFile(const char * fileName)
+{
+	ParseContext ctx = {};
+	ctx.arena = new Arena();
+	ctx.inSitu = true;
+
+	size_t length = 0;
+	char* raw = mapInputFile(*ctx.arena, fileName, length);
+	if (!raw)
+	{
+		delete ctx.arena;
+		return nullptr;
+	}
+
+	return parseRootArray(ctx, raw, length);
+}
+
+EXTERN_C size_t pj_parseNdjson(const char * data, size_t length, unsigned int flags, unsigned int threadCount, pj_RecordCallback callback, void * userData)
+{
+	return parseNdjson(data, length, flags, threadCount, callback, userData);
+}
+
+EXTERN_C size_t pj_parseNdjsonFile(const char * fileName, unsigned int flags, unsigned int threadCount, pj_RecordCallback callback, void * userData)
+{
+	// the records are parsed from the mapping, not in place, so it can go right after
+	Arena file;
+
+	size_t length = 0;
+	const char* data = mapInputFile(file, fileName, length);
+	if (!data) return 0;
+
+	return parseNdjson(data, length, flags, threadCount, callback, userData);
+}
+
+EXTERN_C pj_Array * pj_parseNdjsonArray(const char * data, size_t length, unsigned int flags, unsigned int threadCount, size_t * outCount)
+{
+	pj_Array* array = pj_createArray();
+
+	const size_t count = parseNdjson(data, length, flags, threadCount, [](void* array, size_t, pj_Object* obj, pj_Array* other)
+	{
+		if (obj)
+			pj_arrayAddObj((pj_Array*)array, obj);
+		else if (other)
+			pj_arrayAddArray((pj_Array*)array, other);
+		else
+			pj_arrayAddNull((pj_Array*)array);
+	}, array);
+
+	if (outCount) *outCount = count;
+	return array;
+}
+
+EXTERN_C pj_Array * pj_parseArrayParallel(const char * raw, size_t length, unsigned int flags, unsigned int threadCount)
+{
+	return parseArrayParallel(raw, length, flags, threadCount);
+}
+
+EXTERN_C pj_Array * pj_parseArrayFileParallel(const char * fileName, unsigned int flags, unsigned int threadCount)
+{
+	// the chunks are parsed from copies, so the mapping can go right after
+	Arena file;
+
+	size_t length = 0;
+	const char* raw = mapInputFile(file, fileName, length);
+	if (!raw) return nullptr;
+
+	return parseArrayParallel(raw, length, flags, threadCount);
+}
+
+EXTERN_C void pj_setParseEngine(pj_ParseEngine engine)
+{
+	parseEngine.store(engine, std::memory_order_relaxed);
+}
+
+EXTERN_C pj_ParseEngine pj_getParseEngine()
+{
+	return (pj_ParseEngine)parseEngine.load(std::memory_order_relaxed);
+}
+
+EXTERN_C char * pj_arrayToString(pj_Array * array, pj_boolean isPretty)
+{
+	return pj_arrayToStringLen(array, isPretty, nullptr);
+}
+
+EXTERN_C char * pj_arrayToStringLen(pj_Array * array, pj_boolean isPretty, size_t * outLength)
+{
+	Writer out;
+	arrayToString(out, array, 0, isPretty);
+	return out.release(outLength);
+}
+
+EXTERN_C pj_boolean pj_arrayToFile(pj_Array * array, pj_boolean isPretty, const char* fileName)
+{
+	FILE* file = openForWriting(fileName);
+	if (file == NULL) return false;
+
+	const pj_boolean written = pj_arrayToStream(array, isPretty, file);
+	return (fclose(file) == 0) && written;
+}
+
+EXTERN_C char * pj_objToString(pj_Object* obj, pj_boolean isPretty)
+{
+	return pj_objToStringLen(obj, isPretty, nullptr);
+}
+
+EXTERN_C char * pj_objToStringLen(pj_Object * obj, pj_boolean isPretty, size_t * outLength)
+{
+	Writer out;
+	objectToString(out, obj, 0, isPretty);
+	return out.release(outLength);
+}
+
+EXTERN_C pj_boolean pj_objToFile(pj_Object* obj, pj_boolean isPretty, const char* fileName)
+{
+	FILE* file = openForWriting(fileName);
+	if (file == NULL) return false;
+
+	const pj_boolean written = pj_objToStream(obj, isPretty, file);
+	return (fclose(file) == 0) && written;
+}
+
+EXTERN_C pj_boolean pj_arrayToStream(pj_Array * array, pj_boolean isPretty, FILE * file)
+{
+	return pj_arrayToCallback(array, isPretty, streamSink, file);
+}
+
+EXTERN_C pj_boolean pj_arrayToFd(pj_Array * array, pj_boolean isPretty, int fd)
+{
+	return pj_arrayToCallback(array, isPretty, fdSink, (void*)(intptr_t)fd);
+}
+
+EXTERN_C pj_boolean pj_arrayToCallback(pj_Array * array, pj_boolean isPretty, pj_WriteCallback callback, void * userData)
+{
+	Writer out(callback, userData);
+	arrayToString(out, array, 0, isPretty);
+	return out.flush();
+}
+
+EXTERN_C pj_boolean pj_objToStream(pj_Object * obj, pj_boolean isPretty, FILE * file)
+{
+	return pj_objToCallback(obj, isPretty, streamSink, file);
+}
+
+EXTERN_C pj_boolean pj_objToFd(pj_Object * obj, pj_boolean isPretty, int fd)
+{
+	return pj_objToCallback(obj, isPretty, fdSink, (void*)(intptr_t)fd);
+}
+
+EXTERN_C pj_boolean pj_objToCallback(pj_Object * obj, pj_boolean isPretty, pj_WriteCallback callback, void * userData)
+{
+	Writer out(callback, userData);
+	objectToString(out, obj, 0, isPretty);
+	return out.flush();
+}
+
+EXTERN_C char * pj_arrayToStringParallel(pj_Array * array, pj_boolean isPretty, unsigned int threadCount, size_t * outLength)
+{
+	std::deque<OutputPiece> pieces;
+	serializeParallel(pieces, nullptr, array, isPretty, threadCount);
+	return joinOutput(pieces, outLength);
+}
+
+EXTERN_C char * pj_objToStringParallel(pj_Object * obj, pj_boolean isPretty, unsigned int threadCount, size_t * outLength)
+{
+	std::deque<OutputPiece> pieces;
+	serializeParallel(pieces, obj, nullptr, isPretty, threadCount);
+	return joinOutput(pieces, outLength);
+}
+
+EXTERN_C pj_boolean pj_arrayToFdParallel(pj_Array * array, pj_boolean isPretty, unsigned int threadCount, int fd)
+{
+	std::deque<OutputPiece> pieces;
+	serializeParallel(pieces, nullptr, array, isPretty, threadCount);
+	return writeOutput(pieces, fd);
+}
+
+EXTERN_C pj_boolean pj_objToFdParallel(pj_Object * obj, pj_boolean isPretty, unsigned int threadCount, int fd)
+{
+	std::deque<OutputPiece> pieces;
+	serializeParallel(pieces, obj, nullptr, isPretty, threadCount);
+	return writeOutput(pieces, fd);
+}
+
+EXTERN_C pj_Builder * pj_createBuilder(pj_boolean isPretty, pj_WriteCallback callback, void * userData)
+{
+	assert(callback != nullptr);
+	return new pj_Builder(isPretty, callback, userData);
+}
+
+EXTERN_C pj_Builder * pj_createStreamBuilder(pj_boolean isPretty, FILE * file)
+{
+	return pj_createBuilder(isPretty, streamSink, file);
+}
+
+EXTERN_C pj_Builder * pj_createFdBuilder(pj_boolean isPretty, int fd)
+{
+	return pj_createBuilder(isPretty, fdSink, (void*)(intptr_t)fd);
+}
+
+EXTERN_C pj_boolean pj_finishBuilder(pj_Builder * builder)
+{
+	const bool complete = builder->done && !builder->misused;
+	const bool flushed = builder->out.flush();
+
+	delete builder;
+	return complete && flushed;
+}
+
+EXTERN_C void pj_builderBeginObject(pj_Builder * builder)
+{
+	if (!beginBuilderValue(*builder)) return;
+
+	builder->out.put('{');
+	builder->scopes.push_back({ true, 0 });
+}
+
+EXTERN_C void pj_builderEndObject(pj_Builder * builder)
+{
+	endBuilderScope(*builder, true);
+}
+
+EXTERN_C void pj_builderBeginArray(pj_Builder * builder)
+{
+	if (!beginBuilderValue(*builder)) return;
+
+	builder->out.put('[');
+	builder->scopes.push_back({ false, 0 });
+}
+
+EXTERN_C void pj_builderEndArray(pj_Builder * builder)
+{
+	endBuilderScope(*builder, false);
+}
+
+EXTERN_C void pj_builderKey(pj_Builder * builder, const char * key)
+{
+	if (builder->misused) return;
+
+	if (builder->scopes.empty() || !builder->scopes.back().isObject || builder->hasKey)
+	{
+		builderError(*builder, "Key outside of an object or in place of a value");
+		return;
+	}
+
+	builderSeparate(*builder);
+	builder->out.writeString(key, strlen(key));
+	builder->out.write(": ", 2);
+	builder->hasKey = true;
+}
+
+EXTERN_C void pj_builderNum(pj_Builder * builder, double num)
+{
+	if (!beginBuilderValue(*builder)) return;
+
+	char numBuffer[32];
+	builder->out.write(numBuffer, formatDouble(num, numBuffer));
+	endBuilderValue(*builder);
+}
+
+EXTERN_C void pj_builderInt64(pj_Builder * builder, int64_t num)
+{
+	if (!beginBuilderValue(*builder)) return;
+
+	builder->out.writeInt(num);
+	endBuilderValue(*builder);
+}
+
+EXTERN_C void pj_builderBool(pj_Builder * builder, pj_boolean boolean)
+{
+	if (!beginBuilderValue(*builder)) return;
+
+	if (boolean)
+		builder->out.write("true", 4);
+	else
+		builder->out.write("false", 5);
+
+	endBuilderValue(*builder);
+}
+
+EXTERN_C void pj_builderString(pj_Builder * builder, const char * str)
+{
+	if (!beginBuilderValue(*builder)) return;
+
+	builder->out.writeString(str, strlen(str));
+	endBuilderValue(*builder);
+}
+
+EXTERN_C void pj_builderNull(pj_Builder * builder)
+{
+	if (!beginBuilderValue(*builder)) return;
+
+	builder->out.write("null", 4);
+	endBuilderValue(*builder);
+}
+
+EXTERN_C void pj_builderObj(pj_Builder * builder, pj_Object * obj)
+{
+	if (!beginBuilderValue(*builder)) return;
+
+	objectToString(builder->out, obj, (int)builder->scopes.size(), builder->isPretty);
+	endBuilderValue(*builder);
+}
+
+EXTERN_C void pj_builderArray(pj_Builder * builder, pj_Array * array)
+{
+	if (!beginBuilderValue(*builder)) return;
+
+	arrayToString(builder->out, array, (int)builder->scopes.size(), builder->isPretty);
+	endBuilderValue(*builder);
+}
+
+EXTERN_C pj_SaxParser * pj_createSaxParser(const pj_SaxCallbacks * callbacks, void * userData)
+{
+	pj_SaxParser* parser = new pj_SaxParser();
+	parser->callbacks = *callbacks;
+	parser->userData = userData;
+	return parser;
+}
+
+EXTERN_C void pj_deleteSaxParser(pj_SaxParser * parser)
+{
+	delete parser;
+}
+
+EXTERN_C pj_boolean pj_saxParserFeed(pj_SaxParser * parser, const char * data, size_t length)
+{
+	if (parser->failed) return false;
+
+	appendSaxInput(*parser, data, length);
+	runSaxParser(*parser, false);
+	return !parser->failed;
+}
+
+EXTERN_C pj_boolean pj_saxParserFinish(pj_SaxParser * parser)
+{
+	if (parser->failed) return false;
+
+	runSaxParser(*parser, true);
+
+	if (!parser->failed && parser->state != pj_SaxParser::DONE)
+		saxError(*parser, "Unexpected end of input");
+
+	return !parser->failed;
+}
+
+EXTERN_C pj_Path * pj_compilePath(const char * path)
+{
+	pj_Path* compiled = new pj_Path();
+	if (compilePath(*compiled, path)) return compiled;
+
+	delete compiled;
+	return nullptr;
+}
+
+EXTERN_C void pj_deletePath(pj_Path * path)
+{
+	delete path;
+}
+
+EXTERN_C pj_Extractor * pj_compileExtractor(const pj_Field * fields, size_t count)
+{
+	pj_Extractor* extractor = new pj_Extractor();
+	if (compileExtractor(*extractor, fields, count)) return extractor;
+
+	delete extractor;
+	return nullptr;
+}
+
+EXTERN_C void pj_deleteExtractor(pj_Extractor * extractor)
+{
+	delete extractor;
+}
+
+EXTERN_C size_t pj_objExtract(pj_Object * json, const pj_Extractor * extractor, void * out)
+{
+	// stands in for the root, which it must not delete
+	JsonVal root;
+	root.type = PJ_VALUE_OBJ;
+	root.obj = json;
+	root.isBorrowed = true;
+
+	return extractNode(*extractor, extractor->nodes[0], &root, (char*)out);
+}
+
+EXTERN_C size_t pj_arrayExtract(pj_Array * array, const pj_Extractor * extractor, void * out)
+{
+	JsonVal root;
+	root.type = PJ_VALUE_ARRAY;
+	root.array = array;
+	root.isBorrowed = true;
+
+	return extractNode(*extractor, extractor->nodes[0], &root, (char*)out);
+}
+
+EXTERN_C pj_Object * pj_createObj()
+{
+	return createObj(nullptr);
+}
+
+EXTERN_C void pj_deleteObj(pj_Object* json)
+{
+	if (!json) return;
+
+	if (json->arena)
+	{
+		// only the root owns the arena, everything below it goes with the blocks
+		if (json->arena->root == json) delete json->arena;
+		return;
+	}
+
+	delete json;
+}
+
+EXTERN_C pj_Array * pj_createArray()
+{
+	return createArray(nullptr);
+}
+
+EXTERN_C void pj_deleteArray(pj_Array * array)
+{
+	if (!array) return;
+
+	if (array->arena)
+	{
+		if (array->arena->root == array) delete array->arena;
+		return;
+	}
+
+	for (size_t i = 0; i < array->size; i++)
+		array->items[i].~JsonVal();
+
+	if (array->items)
+		std::pmr::new_delete_resource()->deallocate(array->items, array->capacity * sizeof(JsonVal), alignof(JsonVal));
+
+	delete array;
+}
+
+EXTERN_C void pj_arrayReserve(pj_Array * array, size_t capacity)
+{
+	assert(array != nullptr);
+	reserveArray(*array, capacity);
+}
+
+EXTERN_C void pj_arrayShrinkToFit(pj_Array * array)
+{
+	assert(array != nullptr);
+
+	if (array->size == array->capacity) return;
+
+	reallocateArray(*array, array->size);
+}
+
+EXTERN_C size_t pj_getArrayCapacity(pj_Array * array)
+{
+	return array->capacity;
+}
+
+EXTERN_C void pj_deleteString(char * jsonString)
+{
+	delete[] jsonString;
+}
+
+EXTERN_C double pj_objGetNum(pj_Object * json, const char * propName)
+{
+	return getObjectValue<double, PJ_VALUE_NUMBER>(json, propName);
+}
+
+EXTERN_C int64_t pj_objGetInt64(pj_Object * json, const char * propName)
+{
+	return getObjectValue<int64_t, PJ_VALUE_INT64>(json, propName);
+}
+
+EXTERN_C pj_boolean pj_objGetBool(pj_Object * json, const char * propName)
+{
+	return getObjectValue<pj_boolean, PJ_VALUE_BOOL>(json, propName);
+}
+
+EXTERN_C const char* pj_objGetString(pj_Object * json, const char * propName)
+{
+	return getObjectValue<const char*, PJ_VALUE_STRING>(json, propName);
+}
+
+EXTERN_C pj_Array* pj_objGetArray(pj_Object * json, const char * propName)
+{
+	return getObjectValue<pj_Array*, PJ_VALUE_ARRAY>(json, propName);
+}
+
+EXTERN_C pj_Object* pj_objGetObj(pj_Object * json, const char * propName)
+{
+	return getObjectValue<pj_Object*, PJ_VALUE_OBJ>(json, propName);
+}
+
+EXTERN_C double pj_objGetNumAt(pj_Object * json, const pj_Path * path)
+{
+	return getPathValue<double, PJ_VALUE_NUMBER>(json, nullptr, path);
+}
+
+EXTERN_C int64_t pj_objGetInt64At(pj_Object * json, const pj_Path * path)
+{
+	return getPathValue<int64_t, PJ_VALUE_INT64>(json, nullptr, path);
+}
+
+EXTERN_C pj_boolean pj_objGetBoolAt(pj_Object * json, const pj_Path * path)
+{
+	return getPathValue<pj_boolean, PJ_VALUE_BOOL>(json, nullptr, path);
+}
+
+EXTERN_C const char* pj_objGetStringAt(pj_Object * json, const pj_Path * path)
+{
+	return getPathValue<const char*, PJ_VALUE_STRING>(json, nullptr, path);
+}
+
+EXTERN_C pj_Array* pj_objGetArrayAt(pj_Object * json, const pj_Path * path)
+{
+	return getPathValue<pj_Array*, PJ_VALUE_ARRAY>(json, nullptr, path);
+}
+
+EXTERN_C pj_Object* pj_objGetObjAt(pj_Object * json, const pj_Path * path)
+{
+	return getPathValue<pj_Object*, PJ_VALUE_OBJ>(json, nullptr, path);
+}
+
+EXTERN_C double pj_arrayGetNumAt(pj_Array * array, const pj_Path * path)
+{
+	return getPathValue<double, PJ_VALUE_NUMBER>(nullptr, array, path);
+}
+
+EXTERN_C int64_t pj_arrayGetInt64At(pj_Array * array, const pj_Path * path)
+{
+	return getPathValue<int64_t, PJ_VALUE_INT64>(nullptr, array, path);
+}
+
+EXTERN_C pj_boolean pj_arrayGetBoolAt(pj_Array * array, const pj_Path * path)
+{
+	return getPathValue<pj_boolean, PJ_VALUE_BOOL>(nullptr, array, path);
+}
+
+EXTERN_C const char* pj_arrayGetStringAt(pj_Array * array, const pj_Path * path)
+{
+	return getPathValue<const char*, PJ_VALUE_STRING>(nullptr, array, path);
+}
+
+EXTERN_C pj_Array * pj_arrayGetArrayAt(pj_Array * array, const pj_Path * path)
+{
+	return getPathValue<pj_Array*, PJ_VALUE_ARRAY>(nullptr, array, path);
+}
+
+EXTERN_C pj_Object * pj_arrayGetObjAt(pj_Array * array, const pj_Path * path)
+{
+	return getPathValue<pj_Object*, PJ_VALUE_OBJ>(nullptr, array, path);
+}
+
+EXTERN_C double pj_arrayGetNum(pj_Array * array, size_t index)
+{
+	return getArrayValue<double, PJ_VALUE_NUMBER>(array, index);
+}
+
+EXTERN_C int64_t pj_arrayGetInt64(pj_Array * array, size_t index)
+{
+	return getArrayValue<int64_t, PJ_VALUE_INT64>(array, index);
+}
+
+EXTERN_C pj_boolean pj_arrayGetBool(pj_Array * array, size_t index)
+{
+	return getArrayValue<pj_boolean, PJ_VALUE_BOOL>(array, index);
+}
+
+EXTERN_C const char* pj_arrayGetString(pj_Array * array, size_t index)
+{
+	return getArrayValue<const char*, PJ_VALUE_STRING>(array, index);
+}
+
+EXTERN_C pj_Array * pj_arrayGetArray(pj_Array * array, size_t index)
 {
 	return getArrayValue<pj_Array*, PJ_VALUE_ARRAY>(array, index);
 }
 
-EXTERN_C pj_Object * pj_arrayGetObj(pj_Array * array, size_t index)
+EXTERN_C pj_Object * pj_arrayGetObj(pj_Array * array, size_t index)
+{
+	return getArrayValue<pj_Object*, PJ_VALUE_OBJ>(array, index);
+}
+
+EXTERN_C void pj_arrayAddNum(pj_Array * array, double num)
+{
+	assert(array != nullptr);
+
+	JsonVal val;
+	val.type = PJ_VALUE_NUMBER;
+	val.num = num;
+
+	appendArrayValue(array, std::move(val));
+}
+
+EXTERN_C void pj_arrayAddInt64(pj_Array * array, int64_t num)
+{
+	assert(array != nullptr);
+
+	JsonVal val;
+	val.type = PJ_VALUE_INT64;
+	val.int64 = num;
+
+	appendArrayValue(array, std::move(val));
+}
+
+EXTERN_C void pj_arrayAddBool(pj_Array * array, pj_boolean boolean)
+{
+	assert(array != nullptr);
+
+	JsonVal val;
+	val.type = PJ_VALUE_BOOL;
+	val.boolean = boolean;
+
+	appendArrayValue(array, std::move(val));
+}
+
+EXTERN_C void pj_arrayAddString(pj_Array * array, const char * str)
+{
+	assert(array != nullptr);
+
+	JsonVal val;
+	val.type = PJ_VALUE_STRING;
+	val.string = cpyStringDynamic(str, array->arena);
+
+	appendArrayValue(array, std::move(val));
+}
+
+EXTERN_C void pj_arrayAddArray(pj_Array * array, pj_Array * other)
+{
+	assert(array != nullptr);
+
+	JsonVal val;
+	val.type = PJ_VALUE_ARRAY;
+	val.array = other;
+
+	appendArrayValue(array, std::move(val));
+}
+
+EXTERN_C void pj_arrayAddObj(pj_Array * array, pj_Object * obj)
+{
+	assert(array != nullptr);
+
+	JsonVal val;
+	val.type = PJ_VALUE_OBJ;
+	val.obj = obj;
+
+	appendArrayValue(array, std::move(val));
+}
+
+EXTERN_C void pj_arrayAddNull(pj_Array * array)
+{
+	assert(array != nullptr);
+
+	JsonVal val;
+	val.type = PJ_VALUE_NULL;
+
+	appendArrayValue(array, std::move(val));
+}
+
+EXTERN_C void pj_objSetNum(pj_Object * obj, const char * propName, double num)
+{
+	JsonVal val;
+	val.type = PJ_VALUE_NUMBER;
+	val.num = num;
+
+	setObjectValue(obj, propName, std::move(val));
+}
+
+EXTERN_C void pj_objSetInt64(pj_Object * obj, const char * propName, int64_t num)
+{
+	JsonVal val;
+	val.type = PJ_VALUE_INT64;
+	val.int64 = num;
+
+	setObjectValue(obj, propName, std::move(val));
+}
+
+EXTERN_C void pj_objSetBool(pj_Object * obj, const char * propName, pj_boolean boolean)
+{
+	JsonVal val;
+	val.type = PJ_VALUE_BOOL;
+	val.boolean = boolean;
+
+	setObjectValue(obj, propName, std::move(val));
+}
+
+EXTERN_C void pj_objSetString(pj_Object * obj, const char * propName, const char * str)
+{
+	JsonVal val;
+	val.type = PJ_VALUE_STRING;
+	val.string = cpyStringDynamic(str, obj->arena);
+
+	setObjectValue(obj, propName, std::move(val));
+}
+
+EXTERN_C void pj_objSetArray(pj_Object * obj, const char * propName, pj_Array * array)
+{
+	JsonVal val;
+	val.type = PJ_VALUE_ARRAY;
+	val.array = array;
+
+	setObjectValue(obj, propName, std::move(val));
+}
+
+EXTERN_C void pj_objSetObj(pj_Object * obj, const char * propName, pj_Object * other)
+{
+	JsonVal val;
+	val.type = PJ_VALUE_OBJ;
+	val.obj = other;
+
+	setObjectValue(obj, propName, std::move(val));
+}
+
+EXTERN_C void pj_objSetNull(pj_Object * obj, const char * propName)
+{
+	JsonVal val;
+	val.type = PJ_VALUE_NULL;
+
+	setObjectValue(obj, propName, std::move(val));
+}
+
+
+EXTERN_C pj_ValueType pj_getObjPropType(pj_Object * obj, const char * propName)
+{
+	assert(obj != nullptr);
+
+	if (JsonProp* prop = findProp(*obj, propName))
+	{
+		return prop->val.type;
+	}
+
+	return PJ_VALUE_NULL;
+}
+
+EXTERN_C pj_ValueType pj_getArrayElemType(pj_Array * array, size_t index)
+{
+	assert(index >= 0 && index <= array->size);
+	JsonVal& val = array->items[index];
+	return val.type;
+}
+
+EXTERN_C pj_boolean pj_isArrayElemOfType(pj_Array * array, size_t index, pj_ValueType type)
+{
+	assert(index > 0 && index < array->size);
+	return isValueOfType(array->items[index], type);
+}
+
+EXTERN_C pj_boolean pj_isObjPropOfType(pj_Object * obj, const char * propName, pj_ValueType type)
+{
+	if (JsonProp* prop = findProp(*obj, propName))
+	{
+		return isValueOfType(prop->val, type);
+	}
+
+	return false;
+}
+
+EXTERN_C void pj_objForEachKey(pj_Object * obj, void(*callback)(pj_Object*, const char *))
+{
+	forEachEntry(*obj, [&](ObjectEntry& entry) { callback(obj, entry.key); });
+}
+
+EXTERN_C size_t pj_getArraySize(pj_Array* array)
+{
+	return array->size;
+}
+
+EXTERN_C const char* pj_popError()
+{
+	const std::string& error = errors.pop();
+	return error.size() == 0 ? nullptr : error.c_str();
+}
+
+void parseJSONObject(ParseContext& ctx, Cursor& cursor, pj_Object * json)
+{
+	using namespace std::string_literals;
+	bool done = false;
+
+	{
+		PeekToken pt = peekToken(cursor);
+		if (pt.token.type == Token::CLOSE_BRACE)
+		{
+			// empty object, advance cursor and bail
+			cursor = pt.futureCursor;
+			return;
+		}
+	}
+
+	while (!done && cursor.at != cursor.end)
+	{
+		Token t = getToken(cursor);
+
+		if (t.type == Token::STRING)
+		{
+			Token colon = getToken(cursor);
+
+			if (colon.type == Token::COLON)
+			{
+				size_t nameLength = 0;
+				char* name = parseKeyString(ctx, t, json->size, &nameLength);
+
+				Token val = getToken(cursor);
+
+				JsonProp jprop = {};
+
+				if (!parseJSONValue(ctx, cursor, val, jprop.val))
+				{
+					if (!ctx.arena) delete[] name;
+					return;
+				}
+
+				addParsedProp(ctx, json, name, nameLength, std::move(jprop));
+
+				Token next = getToken(cursor);
+				if (next.type == Token::CLOSE_BRACE)
+				{
+					done = true;
+				}
+				else if (next.type != Token::COMMA)
+				{
+					errors.push("PARSER :: Missing comma after property value; LINENO: "s + std::to_string(cursor.lineNo));
+					return;
+				}
+			}
+			else
+			{
+				errors.push("PARSER :: Expected Colon after property name; LINENO: "s + std::to_string(cursor.lineNo));
+				break;
+				// TODO: ERROR
+			}
+		}
+		else
+		{
+			// a closing brace right after a comma is a trailing comma, which JSON does not allow
+			errors.push("PARSER :: Expected property name; LINENO: "s + std::to_string(cursor.lineNo));
+			return;
+		}
+	}
+}
+
+void parseJSONArray(ParseContext& ctx, Cursor & cursor, pj_Array * array)
+{
+	{
+		PeekToken pt = peekToken(cursor);
+		if (pt.token.type == Token::SQUARE_BRACKET_CLOSE)
+		{
+			// empty array, advance cursor and bail
+			cursor = pt.futureCursor;
+			return;
+		}
+	}
+
+	{
+		// pre-size from a bounded lookahead; if the closing bracket is out of reach
+		// this is only a lower bound and geometric growth covers the rest
+		const size_t count = countArrayElements(cursor.at, cursor.end);
+		reserveArray(*array, array->size + count);
+	}
+
+	while (cursor.at != cursor.end)
+	{
+		Token item = getToken(cursor);
+		JsonVal val = {};
+
+		if (!parseJSONValue(ctx, cursor, item, val))
+		{
+			// TODO: ERROR HANDLING
+			return;
+		}
+
+		addArrayValue(*array, std::move(val));
+
+		Token next = getToken(cursor);
+		if (next.type == Token::SQUARE_BRACKET_CLOSE)
+		{
+			break; // done
+		}
+		else if (next.type != Token::COMMA)
+		{
+			using namespace std::string_literals;
+			errors.push("PARSER :: Missing comma after array element; LINENO: "s + std::to_string(cursor.lineNo));
+			break;
+			// TODO: ERROR
+		}
+	}
+}
+
+bool parseJSONValue(ParseContext& ctx, Cursor & cursor, Token & valueToken, JsonVal & val)
+{
+	val.isBorrowed = ctx.arena != nullptr;
+
+	switch (valueToken.type)
+	{
+	case Token::SQUARE_BRACKET_OPEN:
+		if (ctx.lazy) return deferValue(ctx, cursor, valueToken, val);
+
+		val.type = PJ_VALUE_ARRAY;
+		val.array = createArray(ctx.arena);
+		val.array->source = beginSourceSpan(ctx, valueToken.str);
+		parseJSONArray(ctx, cursor, val.array);
+		endSourceSpan(ctx, val.array->source, cursor.at);
+		break;
+	case Token::OPEN_BRACE:
+		if (ctx.lazy) return deferValue(ctx, cursor, valueToken, val);
+
+		val.type = PJ_VALUE_OBJ;
+		val.obj = createObj(ctx.arena);
+		val.obj->source = beginSourceSpan(ctx, valueToken.str);
+		parseJSONObject(ctx, cursor, val.obj);
+		endSourceSpan(ctx, val.obj->source, cursor.at);
+		break;
+	default:
+		if (!parseScalarValue(ctx, valueToken, val))
+		{
+			using namespace std::string_literals;
+			errors.push("PARSER :: Value Token of unknown or unspecified type; LINENO: "s + std::to_string(cursor.lineNo));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// records the object or array opening at valueToken and moves the cursor past it
+bool deferValue(ParseContext& ctx, Cursor& cursor, const Token& valueToken, JsonVal& val)
+{
+	const char* end = skipContainer(valueToken.str, cursor.end);
+	if (!end)
+	{
+		using namespace std::string_literals;
+		errors.push("PARSER :: Unterminated object or array; LINENO: "s + std::to_string(cursor.lineNo));
+		return false;
+	}
+
+	SourceSpan* span = createSourceSpan(ctx, valueToken.str, cursor.lineNo);
+	span->end = end;
+
+	cursor.lineNo += std::count(cursor.at, end, '\n');
+	cursor.at = end;
+
+	val.type = valueToken.type == Token::OPEN_BRACE ? PJ_VALUE_OBJ : PJ_VALUE_ARRAY;
+	val.lazy = span;
+	val.isLazy = true;
+	return true;
+}
+
+// parses one level of a deferred object or array, its own nested values stay deferred
+void materializeValue(JsonVal& val)
+{
+	if (!val.isLazy) return;
+
+	SourceSpan* span = val.lazy;
+	const size_t pushed = errors.pushed;
+
+	ParseContext ctx = {};
+	ctx.arena = span->arena;
+	ctx.lazy = true;
+	ctx.span = span;
+
+	Cursor cursor = { span->at + 1, span->end, span->lineNo };
+
+	if (val.type == PJ_VALUE_OBJ)
+	{
+		pj_Object* obj = createObj(ctx.arena);
+		parseJSONObject(ctx, cursor, obj);
+		obj->source = span;
+		val.obj = obj;
+	}
+	else
+	{
+		pj_Array* array = createArray(ctx.arena);
+		parseJSONArray(ctx, cursor, array);
+		array->source = span;
+		val.array = array;
+	}
+
+	val.isLazy = false;
+
+	// the text is invalid, so are the spans around it
+	if (errors.pushed != pushed) markModified(span);
+}
+
+SourceSpan* createSourceSpan(ParseContext& ctx, const char* at, size_t lineNo)
+{
+	SourceSpan* span = ctx.arena->create<SourceSpan>();
+	span->at = at;
+	span->end = nullptr;
+	span->lineNo = lineNo;
+	span->arena = ctx.arena;
+	span->parent = ctx.span;
+	span->isModified = false;
+	return span;
+}
+
+// opens the span of the object or array whose opening bracket is at 'at' and makes it the
+// parent of the spans opened until endSourceSpan. null unless the document keeps its source
+SourceSpan* beginSourceSpan(ParseContext& ctx, const char* at)
+{
+	if (!ctx.arena || !ctx.arena->keepSource) return nullptr;
+
+	ctx.span = createSourceSpan(ctx, at, 0);
+	return ctx.span;
+}
+
+void endSourceSpan(ParseContext& ctx, SourceSpan* span, const char* end)
+{
+	if (!span) return;
+
+	span->end = end;
+	ctx.span = span->parent;
+}
+
+void markModified(SourceSpan* span)
+{
+	// the parents of a modified span are modified too, so the walk stops at the first one
+	for (; span && !span->isModified; span = span->parent)
+		span->isModified = true;
+}
+
+// copies the input text of an unmodified node, returns false if it has to be serialized
+bool writeSource(Writer& out, const SourceSpan* span)
+{
+	if (!span || span->isModified || !span->arena->keepSource) return false;
+
+	out.write(span->at, span->end - span->at);
+	return true;
+}
+
+Token indexedToken(IndexCursor & cursor)
+{
+	if (cursor.at == cursor.end) return EOFToken();
+
+	const char* str = cursor.raw + *cursor.at++;
+
+	Token t = {};
+	t.length = 1;
+	t.str = str;
+
+	switch (*str)
+	{
+	case '{': t.type = Token::OPEN_BRACE;           return t;
+	case '}': t.type = Token::CLOSE_BRACE;          return t;
+	case ':': t.type = Token::COLON;                return t;
+	case ',': t.type = Token::COMMA;                return t;
+	case '[': t.type = Token::SQUARE_BRACKET_OPEN;  return t;
+	case ']': t.type = Token::SQUARE_BRACKET_CLOSE; return t;
+	case '"':
+		t = parseStringToken(str, cursor.rawEnd);
+		if (t.type == Token::UNKNOWN)
+		{
+			using namespace std::string_literals;
+			errors.push("Unknown token for assumed string literal. Check closing \"; LINENO: "s + std::to_string(indexedLineNo(cursor)));
+		}
+
+		return t;
+	case 'f':
+	case 't':
+	case 'n':
+		t = parseAlNumLiteralToken(str, cursor.rawEnd);
+		break;
+	default:
+		if (isdigit(*str) || *str == '-')
+		{
+			t = parseNumToken(str, cursor.rawEnd);
+		}
+		else
+		{
+			return unknownToken();
+		}
+	}
+
+	// stage one only records where a scalar starts, it also has to end where a value may
+	const char next = charAt(str + t.length, cursor.rawEnd);
+	if (!isJsonSpace(next) && next != ',' && next != ']' && next != '}' && next != 0)
+		return unknownToken();
+
+	return t;
+}
+
+size_t indexedLineNo(const IndexCursor & cursor)
+{
+	// only errors need a line number, so count them on demand up to the last token read
+	return std::count(cursor.raw, cursor.raw + cursor.at[-1], '\n');
+}
+
+// one past the last structural character read
+const char* indexedEnd(const IndexCursor & cursor)
+{
+	return cursor.raw + cursor.at[-1] + 1;
+}
+
+void parseIndexedObject(ParseContext& ctx, IndexCursor & cursor, pj_Object * json)
+{
+	using namespace std::string_literals;
+
+	Token t = indexedToken(cursor);
+	if (t.type == Token::CLOSE_BRACE) return;
+
+	for (;;)
+	{
+		if (t.type != Token::STRING)
+		{
+			errors.push("PARSER :: Expected property name; LINENO: "s + std::to_string(indexedLineNo(cursor)));
+			return;
+		}
+
+		if (indexedToken(cursor).type != Token::COLON)
+		{
+			errors.push("PARSER :: Expected Colon after property name; LINENO: "s + std::to_string(indexedLineNo(cursor)));
+			return;
+		}
+
+		size_t nameLength = 0;
+		char* name = parseKeyString(ctx, t, json->size, &nameLength);
+
+		Token val = indexedToken(cursor);
+		JsonProp jprop = {};
+
+		if (!parseIndexedValue(ctx, cursor, val, jprop.val))
+		{
+			if (!ctx.arena) delete[] name;
+			return;
+		}
+
+		addParsedProp(ctx, json, name, nameLength, std::move(jprop));
+
+		Token next = indexedToken(cursor);
+		if (next.type == Token::CLOSE_BRACE) return;
+
+		if (next.type != Token::COMMA)
+		{
+			errors.push("PARSER :: Missing comma after property value; LINENO: "s + std::to_string(indexedLineNo(cursor)));
+			return;
+		}
+
+		t = indexedToken(cursor);
+	}
+}
+
+void parseIndexedArray(ParseContext& ctx, IndexCursor & cursor, pj_Array * array)
+{
+	Token item = indexedToken(cursor);
+	if (item.type == Token::SQUARE_BRACKET_CLOSE) return;
+
+	for (;;)
+	{
+		JsonVal val = {};
+
+		if (!parseIndexedValue(ctx, cursor, item, val)) return;
+
+		addArrayValue(*array, std::move(val));
+
+		Token next = indexedToken(cursor);
+		if (next.type == Token::SQUARE_BRACKET_CLOSE) return;
+
+		if (next.type != Token::COMMA)
+		{
+			using namespace std::string_literals;
+			errors.push("PARSER :: Missing comma after array element; LINENO: "s + std::to_string(indexedLineNo(cursor)));
+			return;
+		}
+
+		item = indexedToken(cursor);
+	}
+}
+
+bool parseIndexedValue(ParseContext& ctx, IndexCursor & cursor, Token & valueToken, JsonVal & val)
+{
+	val.isBorrowed = ctx.arena != nullptr;
+
+	switch (valueToken.type)
+	{
+	case Token::SQUARE_BRACKET_OPEN:
+		val.type = PJ_VALUE_ARRAY;
+		val.array = createArray(ctx.arena);
+		val.array->source = beginSourceSpan(ctx, valueToken.str);
+		parseIndexedArray(ctx, cursor, val.array);
+		endSourceSpan(ctx, val.array->source, indexedEnd(cursor));
+		break;
+	case Token::OPEN_BRACE:
+		val.type = PJ_VALUE_OBJ;
+		val.obj = createObj(ctx.arena);
+		val.obj->source = beginSourceSpan(ctx, valueToken.str);
+		parseIndexedObject(ctx, cursor, val.obj);
+		endSourceSpan(ctx, val.obj->source, indexedEnd(cursor));
+		break;
+	default:
+		if (!parseScalarValue(ctx, valueToken, val))
+		{
+			using namespace std::string_literals;
+			errors.push("PARSER :: Value Token of unknown or unspecified type; LINENO: "s + std::to_string(indexedLineNo(cursor)));
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool parseScalarValue(ParseContext& ctx, const Token & valueToken, JsonVal & val)
+{
+	switch (valueToken.type)
+	{
+	case Token::BOOL:
+		val.type = PJ_VALUE_BOOL;
+
+		if (cmpSubStr(valueToken.str, "false", valueToken.length))
+		{
+			val.boolean = false;
+		}
+		else if (cmpSubStr(valueToken.str, "true", valueToken.length))
+		{
+			val.boolean = true;
+		}
+
+		break;
+	case Token::NUMBER:
+		val.type = parseNumber(valueToken.str, valueToken.length, val.num, val.int64) ? PJ_VALUE_INT64 : PJ_VALUE_NUMBER;
+		break;
+	case Token::STRING:
+		val.type = PJ_VALUE_STRING;
+		val.string = parseCString(ctx, valueToken, nullptr);
+		break;
+	case Token::JSON_NULL:
+		val.type = PJ_VALUE_NULL;
+		break;
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+void addParsedProp(ParseContext& ctx, pj_Object * json, char * name, size_t nameLength, JsonProp && prop)
+{
+	// the first occurrence of a duplicate key wins
+	if (internsKeys(*json) ? findInternedEntry(*json, name) : findEntry(*json, name, nameLength))
+	{
+		if (!ctx.arena) delete[] name;
+		return;
+	}
+
+	insertEntry(*json, name, nameLength).prop = std::move(prop);
+}
+
+void objectToString(Writer& out, pj_Object * obj, int depth, pj_boolean isPretty)
+{
+	if (!isPretty && writeSource(out, obj->source)) return;
+
+	// empty containers stay on one line when pretty printing, as the builder writes them
+	if (obj->size == 0)
+	{
+		out.write("{}", 2);
+		return;
+	}
+
+	out.put('{');
+	if (isPretty) out.put('\n');
+
+	writeObjectEntries(out, obj, 0, obj->size, depth, isPretty);
+
+	if (isPretty)
+	{
+		out.put('\n');
+		out.indent(depth);
+	}
+
+	out.put('}');
+}
+
+void arrayToString(Writer& out, pj_Array * array, int depth, pj_boolean isPretty)
+{
+	if (!isPretty && writeSource(out, array->source)) return;
+
+	if (array->size == 0)
+	{
+		out.write("[]", 2);
+		return;
+	}
+
+	out.put('[');
+	if (isPretty) out.put('\n');
+
+	writeArrayItems(out, array, 0, array->size, depth, isPretty);
+
+	if (isPretty)
+	{
+		out.put('\n');
+		out.indent(depth);
+	}
+
+	out.put(']');
+}
+
+// writes the members [begin, end) of obj, each followed by a comma unless it is its last
+void writeObjectEntries(Writer& out, pj_Object* obj, size_t begin, size_t end, int depth, pj_boolean isPretty)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		ObjectEntry& entry = obj->entries[i];
+		if (isPretty) out.indent(depth + 1);
+
+		out.writeString(entry.key, entry.keyLength);
+		out.write(": ", 2);
+
+		valueToString(out, entry.prop.val, depth, isPretty);
+		const bool isLast = i == obj->size - 1;
+
+		if (!isLast)
+		{
+			out.put(',');
+			if (isPretty) out.put('\n');
+		}
+	}
+}
+
+void writeArrayItems(Writer& out, pj_Array* array, size_t begin, size_t end, int depth, pj_boolean isPretty)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		if (isPretty) out.indent(depth + 1);
+
+		valueToString(out, array->items[i], depth, isPretty);
+
+		const bool isLast = i == array->size - 1;
+
+		if (!isLast)
+		{
+			out.put(',');
+			if (isPretty) out.put('\n');
+		}
+	}
+}
+
+// Pretty printing a lazy document parses it into its arena, which only one thread may do
+bool canSplitOutput(Arena* arena, size_t size, pj_boolean isPretty)
+{
+	return size >= PARALLEL_SPLIT_SIZE && !(isPretty && arena && arena->lazy);
+}
+
+// hands the members of obj or array to workers in chunks, the text after them goes to a new piece
+void splitOutput(std::deque<OutputPiece>& pieces, pj_Object* obj, pj_Array* array, size_t size, int depth)
+{
+	for (size_t begin = 0; begin < size; begin += PARALLEL_CHUNK_MEMBERS)
+	{
+		OutputPiece& piece = pieces.emplace_back();
+		piece.obj = obj;
+		piece.array = array;
+		piece.begin = begin;
+		piece.end = std::min(size, begin + PARALLEL_CHUNK_MEMBERS);
+		piece.depth = depth;
+	}
+
+	pieces.emplace_back();
+}
+
+// Writes obj the way objectToString does, except that large arrays and objects within are left
+// to workers. Text goes to the last piece, which may be replaced by newer ones on the way
+void planObjectOutput(std::deque<OutputPiece>& pieces, pj_Object* obj, int depth, pj_boolean isPretty)
+{
+	if (!isPretty && writeSource(pieces.back().out, obj->source)) return;
+
+	if (obj->size == 0)
+	{
+		pieces.back().out.write("{}", 2);
+		return;
+	}
+
+	pieces.back().out.put('{');
+	if (isPretty) pieces.back().out.put('\n');
+
+	if (canSplitOutput(obj->arena, obj->size, isPretty))
+	{
+		splitOutput(pieces, obj, nullptr, obj->size, depth);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < obj->size; i++)
+		{
+			ObjectEntry& entry = obj->entries[i];
+			if (isPretty) pieces.back().out.indent(depth + 1);
+
+			pieces.back().out.writeString(entry.key, entry.keyLength);
+			pieces.back().out.write(": ", 2);
+
+			planValueOutput(pieces, entry.prop.val, depth, isPretty);
+
+			if (i != obj->size - 1)
+			{
+				pieces.back().out.put(',');
+				if (isPretty) pieces.back().out.put('\n');
+			}
+		}
+	}
+
+	Writer& out = pieces.back().out;
+	if (isPretty)
+	{
+		out.put('\n');
+		out.indent(depth);
+	}
+
+	out.put('}');
+}
+
+void planArrayOutput(std::deque<OutputPiece>& pieces, pj_Array* array, int depth, pj_boolean isPretty)
+{
+	if (!isPretty && writeSource(pieces.back().out, array->source)) return;
+
+	if (array->size == 0)
+	{
+		pieces.back().out.write("[]", 2);
+		return;
+	}
+
+	pieces.back().out.put('[');
+	if (isPretty) pieces.back().out.put('\n');
+
+	if (canSplitOutput(array->arena, array->size, isPretty))
+	{
+		splitOutput(pieces, nullptr, array, array->size, depth);
+	}
+	else
+	{
+		for (size_t i = 0; i < array->size; i++)
+		{
+			if (isPretty) pieces.back().out.indent(depth + 1);
+
+			planValueOutput(pieces, array->items[i], depth, isPretty);
+
+			if (i != array->size - 1)
+			{
+				pieces.back().out.put(',');
+				if (isPretty) pieces.back().out.put('\n');
+			}
+		}
+	}
+
+	Writer& out = pieces.back().out;
+	if (isPretty)
+	{
+		out.put('\n');
+		out.indent(depth);
+	}
+
+	out.put(']');
+}
+
+void planValueOutput(std::deque<OutputPiece>& pieces, JsonVal& val, int depth, pj_boolean isPretty)
+{
+	// deferred values are copied or parsed as they are by valueToString
+	if (val.type == PJ_VALUE_OBJ && !val.isLazy)
+		planObjectOutput(pieces, val.obj, depth + 1, isPretty);
+	else if (val.type == PJ_VALUE_ARRAY && !val.isLazy)
+		planArrayOutput(pieces, val.array, depth + 1, isPretty);
+	else
+		valueToString(pieces.back().out, val, depth, isPretty);
+}
+
+void serializeParallel(std::deque<OutputPiece>& pieces, pj_Object* obj, pj_Array* array, pj_boolean isPretty, unsigned int threadCount)
+{
+	pieces.emplace_back();
+	if (obj)
+		planObjectOutput(pieces, obj, 0, isPretty);
+	else
+		planArrayOutput(pieces, array, 0, isPretty);
+
+	std::vector<OutputPiece*> tasks;
+	for (OutputPiece& piece : pieces)
+		if (piece.obj || piece.array) tasks.push_back(&piece);
+
+	runParallel(tasks.size(), threadCount, [&](size_t task)
+	{
+		OutputPiece& piece = *tasks[task];
+		if (piece.obj)
+			writeObjectEntries(piece.out, piece.obj, piece.begin, piece.end, piece.depth, isPretty);
+		else
+			writeArrayItems(piece.out, piece.array, piece.begin, piece.end, piece.depth, isPretty);
+	});
+}
+
+char* joinOutput(std::deque<OutputPiece>& pieces, size_t* outLength)
+{
+	size_t length = 0;
+	for (const OutputPiece& piece : pieces) length += piece.out.size;
+
+	Writer out;
+	out.reserve(length);
+	for (const OutputPiece& piece : pieces) out.write(piece.out.buffer, piece.out.size);
+
+	return out.release(outLength);
+}
+
+bool writeOutput(std::deque<OutputPiece>& pieces, int fd)
+{
+#if defined (_WIN32) || defined(_WIN64)
+	for (const OutputPiece& piece : pieces)
+		if (fdSink((void*)(intptr_t)fd, piece.out.buffer, piece.out.size) != piece.out.size) return false;
+
+	return true;
+#else
+#ifdef IOV_MAX
+	const size_t maxBuffers = IOV_MAX;
+#else
+	const size_t maxBuffers = 16;
+#endif
+
+	std::vector<iovec> buffers;
+	for (const OutputPiece& piece : pieces)
+		if (piece.out.size) buffers.push_back({ piece.out.buffer, piece.out.size });
+
+	size_t first = 0;
+	while (first < buffers.size())
+	{
+		const ssize_t result = ::writev(fd, &buffers[first], (int)std::min(buffers.size() - first, maxBuffers));
+		if (result < 0)
+		{
+			if (errno == EINTR) continue;
+			return false;
+		}
+
+		// pipes and sockets may take less than asked for, even part of a buffer
+		size_t written = (size_t)result;
+		while (first < buffers.size() && written >= buffers[first].iov_len)
+			written -= buffers[first++].iov_len;
+
+		if (written)
+		{
+			buffers[first].iov_base = (char*)buffers[first].iov_base + written;
+			buffers[first].iov_len -= written;
+		}
+	}
+
+	return true;
+#endif
+}
+
+void valueToString(Writer& out, JsonVal & val, int depth, pj_boolean isPretty)
+{
+	switch (val.type)
+	{
+	case PJ_VALUE_NUMBER:
+	{
+		char numBuffer[32];
+		out.write(numBuffer, formatDouble(val.num, numBuffer));
+		break;
+	}
+	case PJ_VALUE_INT64:
+		out.writeInt(val.int64);
+		break;
+	case PJ_VALUE_STRING:
+		out.writeString(val.string, strlen(val.string));
+		break;
+	case PJ_VALUE_BOOL:
+		if (val.boolean)
+			out.write("true", 4);
+		else
+			out.write("false", 5);
+		break;
+	case PJ_VALUE_OBJ:
+	case PJ_VALUE_ARRAY:
+		if (val.isLazy && !isPretty)
+		{
+			out.write(val.lazy->at, val.lazy->end - val.lazy->at);
+			break;
+		}
+
+		materializeValue(val);
+		if (val.type == PJ_VALUE_OBJ)
+			objectToString(out, val.obj, depth + 1, isPretty);
+		else
+			arrayToString(out, val.array, depth + 1, isPretty);
+		break;
+	case PJ_VALUE_NULL:
+		out.write("null", 4);
+		break;
+	}
+}
+
+FILE* openForWriting(const char* fileName)
+{
+	FILE* file = fopen(fileName, "w");
+	if (file == NULL)
+	{
+		std::string error = "Cannot open file: ";
+		error += fileName;
+		errors.push(error);
+	}
+
+	return file;
+}
+
+// Maps the file copy on write, in situ decoding only copies the pages it touches.
+// Anything that cannot be mapped (pipes, empty files, Windows) is read instead
+char* mapInputFile(Arena& arena, const char* fileName, size_t& length)
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+	const int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+	{
+		std::string error = "Cannot open file: ";
+		error += fileName;
+		errors.push(error);
+		return nullptr;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+	{
+		const size_t fileSize = (size_t)info.st_size;
+
+		void* mapping = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED)
+		{
+			close(fd);
+
+			arena.mapping = mapping;
+			arena.mappingSize = fileSize;
+			length = fileSize;
+			return (char*)mapping;
+		}
+	}
+
+	close(fd);
+#endif
+
+	return readInputFile(arena, fileName, length);
+}
+
+char* readInputFile(Arena& arena, const char* fileName, size_t& length)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (file == NULL)
+	{
+		std::string error = "Cannot open file: ";
+		error += fileName;
+		errors.push(error);
+		return nullptr;
+	}
+
+	std::vector<char> data;
+	char chunk[STREAM_BUFFER_SIZE];
+	size_t read;
+
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		data.insert(data.end(), chunk, chunk + read);
+
+	const bool failed = ferror(file);
+	fclose(file);
+
+	if (failed)
+	{
+		std::string error = "Cannot read file: ";
+		error += fileName;
+		errors.push(error);
+		return nullptr;
+	}
+
+	char* raw = allocString(&arena, data.size());
+	if (!data.empty()) memcpy(raw, data.data(), data.size());
+	raw[data.size()] = 0;
+
+	length = data.size();
+	return raw;
+}
+
+void unmapInputFile(void* mapping, size_t size)
+{
+#if !defined(_WIN32) && !defined(_WIN64)
+	munmap(mapping, size);
+#endif
+}
+
+size_t streamSink(void* file, const char* data, size_t length)
+{
+	return fwrite(data, 1, length, (FILE*)file);
+}
+
+size_t fdSink(void* fd, const char* data, size_t length)
+{
+	const int handle = (int)(intptr_t)fd;
+	size_t written = 0;
+
+	// pipes and sockets may take less than asked for
+	while (written < length)
+	{
+#if defined (_WIN32) || defined(_WIN64)
+		const int result = _write(handle, data + written, (unsigned int)std::min<size_t>(length - written, 1u << 30));
+#else
+		const ssize_t result = ::write(handle, data + written, length - written);
+#endif
+		if (result < 0)
+		{
+			if (errno == EINTR) continue;
+			break;
+		}
+
+		written += (size_t)result;
+	}
+
+	return written;
+}
+
+void addArrayValue(pj_Array & array, JsonVal && val)
+{
+	if (array.size == array.capacity)
+	{
+		const size_t newCapacity = array.capacity ? array.capacity * 2 : MIN_ARRAY_CAPACITY;
+		reserveArray(array, newCapacity);
+	}
+
+	adoptValue(array.arena, val);
+
+	new (&array.items[array.size]) JsonVal(std::move(val));
+	array.size++;
+}
+
+void reserveArray(pj_Array & array, size_t capacity)
+{
+	if (capacity <= array.capacity) return;
+
+	reallocateArray(array, capacity);
+}
+
+void reallocateArray(pj_Array & array, size_t capacity)
+{
+	assert(capacity >= array.size);
+
+	// items are raw storage, only [0, size) holds constructed values
+	std::pmr::memory_resource* resource = resourceOf(array.arena);
+	JsonVal* newItems = capacity ? (JsonVal*)resource->allocate(capacity * sizeof(JsonVal), alignof(JsonVal)) : nullptr;
+
+	for (size_t i = 0; i < array.size; i++)
+	{
+		new (&newItems[i]) JsonVal(std::move(array.items[i]));
+		array.items[i].~JsonVal();
+	}
+
+	if (array.items)
+		resource->deallocate(array.items, array.capacity * sizeof(JsonVal), alignof(JsonVal));
+
+	array.items = newItems;
+	array.capacity = capacity;
+}
+
+size_t countArrayElements(const char * at, const char * end)
+{
+	// counts the top level elements of the array whose contents begin at 'at',
+	// giving up after ARRAY_LOOKAHEAD bytes so nested arrays stay linear overall
+	const ScanKernels& kernels = scanKernels();
+	if ((size_t)(end - at) > ARRAY_LOOKAHEAD) end = at + ARRAY_LOOKAHEAD;
+	// nothing but whitespace before the closing bracket means no elements at all
+	size_t newlines = 0;
+	at = kernels.skipWhitespace(at, end, newlines);
+	if (at < end && *at == ']') return 0;
+
+	size_t count = 1;
+	int depth = 0;
+
+	for (;; at++)
+	{
+		at = kernels.findStructural(at, end);
+		if (at >= end || *at == 0) return count;
+
+		switch (*at)
+		{
+		case '"':
+			for (at++;; at += 2)
+			{
+				at = kernels.findQuoteOrEscape(at, end);
+				if (at >= end || *at != '\\') break;
+			}
+			if (at >= end || *at == 0) return count;
+			break;
+		case '[':
+		case '{':
+			depth++;
+			break;
+		case ']':
+		case '}':
+			if (depth == 0) return count;
+			depth--;
+			break;
+		case ',':
+			if (depth == 0) count++;
+			break;
+		}
+	}
+
+	return count;
+}
+
+// returns one past the bracket closing the object or array that opens at 'at', or null if
+// the input ends first. brackets are only counted, not matched, and only outside of strings
+const char* skipContainer(const char* at, const char* end)
+{
+	const char* closed = nullptr;
+	size_t depth = 0;
+
+	scanBlocks(at, end, [&](const char* block, const BlockBits& bits)
+	{
+		for (uint64_t ops = bits.op; ops; ops &= ops - 1)
+		{
+			const uint32_t i = lowestBitIndex(ops);
+			if (bits.bytes[i] == '[' || bits.bytes[i] == '{')
+			{
+				depth++;
+			}
+			else if ((bits.bytes[i] == ']' || bits.bytes[i] == '}') && --depth == 0)
+			{
+				closed = block + i + 1;
+				return false;
+			}
+		}
+
+		return true;
+	});
+
+	return closed;
+}
+
+// returns the first newline outside of a string from 'at' on, or end
+const char* findRecordEnd(const char* at, const char* end)
+{
+	const char* recordEnd = end;
+
+	scanBlocks(at, end, [&](const char* block, const BlockBits& bits)
+	{
+		for (uint64_t spaces = bits.whitespace; spaces; spaces &= spaces - 1)
+		{
+			const uint32_t i = lowestBitIndex(spaces);
+			if (bits.bytes[i] == '\n')
+			{
+				recordEnd = block + i;
+				return false;
+			}
+		}
+
+		return true;
+	});
+
+	return recordEnd;
+}
+
+// splits off up to NDJSON_WINDOW records and returns where the next ones start
+const char* splitRecords(const char* at, const char* end, size_t& lineNo, std::vector<NdjsonRecord>& records)
+{
+	const ScanKernels& kernels = scanKernels();
+	records.clear();
+
+	while (records.size() < NDJSON_WINDOW)
+	{
+		size_t newlines = 0;
+		at = kernels.skipWhitespace(at, end, newlines);
+		lineNo += newlines;
+		if (at == end) break;
+
+		const char* recordEnd = findRecordEnd(at, end);
+
+		NdjsonRecord record = {};
+		record.at = at;
+		record.length = recordEnd - at;
+		record.lineNo = lineNo;
+		records.push_back(std::move(record));
+
+		// strings may still hold newlines
+		lineNo += std::count(at, recordEnd, '\n');
+		at = recordEnd;
+	}
+
+	return at;
+}
+
+void parseRecord(NdjsonRecord& record, unsigned int flags)
+{
+	const size_t pushed = errors.pushed;
+
+	ParseContext ctx = {};
+	const char* raw = openParseContext(ctx, record.at, record.length, flags);
+
+	if (*raw == '{')
+	{
+		record.obj = parseRootObj(ctx, raw, record.length);
+	}
+	else if (*raw == '[')
+	{
+		record.array = parseRootArray(ctx, raw, record.length);
+	}
+	else
+	{
+		delete ctx.arena;
+		errors.push("PARSER :: Expected object or array");
+	}
+
+	if (errors.pushed == pushed) return;
+
+	takeErrors(pushed, record.errors);
+
+	pj_deleteObj(record.obj);
+	pj_deleteArray(record.array);
+	record.obj = nullptr;
+	record.array = nullptr;
+}
+
+size_t parseNdjson(const char* data, size_t length, unsigned int flags, unsigned int threadCount, pj_RecordCallback callback, void* userData)
+{
+	const char* at = data;
+	const char* const end = data + length;
+
+	std::vector<NdjsonRecord> records;
+	size_t lineNo = 0;
+	size_t count = 0;
+
+	while (at != end)
+	{
+		at = splitRecords(at, end, lineNo, records);
+
+		const size_t tasks = (records.size() + NDJSON_BATCH - 1) / NDJSON_BATCH;
+		runParallel(tasks, threadCount, [&](size_t task)
+		{
+			const size_t last = std::min(records.size(), (task + 1) * NDJSON_BATCH);
+			for (size_t i = task * NDJSON_BATCH; i < last; i++) parseRecord(records[i], flags);
+		});
+
+		for (NdjsonRecord& record : records)
+		{
+			pushTakenErrors(record.errors, "NDJSON", "RECORD LINENO", record.lineNo);
+			callback(userData, count++, record.obj, record.array);
+		}
+	}
+
+	return count;
+}
+
+// workers die with their error stacks, so the errors raised since pushed are moved out
+void takeErrors(size_t pushed, std::vector<std::string>& taken)
+{
+	for (size_t i = std::min(errors.pushed - pushed, MAX_ERRORS); i > 0; i--)
+		taken.push_back(errors.pop());
+}
+
+// pushes errors moved out by takeErrors back onto this thread, oldest first so they pop in
+// the order they were raised
+void pushTakenErrors(const std::vector<std::string>& taken, const char* area, const char* place, size_t lineNo)
+{
+	for (auto error = taken.rbegin(); error != taken.rend(); ++error)
+		errors.push(std::string(area) + " :: " + *error + "; " + place + ": " + std::to_string(lineNo));
+}
+
+// Cuts the elements of the array whose contents begin at 'at' into chunks of at least
+// ARRAY_CHUNK_SIZE bytes, the last one aside, at top level commas. Returns false when the
+// closing bracket is not found, or when nothing follows the last cut
+bool splitArrayChunks(const char* at, const char* end, size_t lineNo, std::vector<ArrayChunk>& chunks)
+{
+	const ScanKernels& kernels = scanKernels();
+
+	size_t depth = 0;
+	bool closed = false;
+
+	const char* chunkAt = at;
+	const auto cut = [&](const char* chunkEnd)
+	{
+		ArrayChunk chunk = {};
+		chunk.at = chunkAt;
+		chunk.length = chunkEnd - chunkAt;
+		chunk.lineNo = lineNo;
+		chunks.push_back(std::move(chunk));
+
+		lineNo += std::count(chunkAt, chunkEnd, '\n');
+		chunkAt = chunkEnd + 1;
+	};
+
+	scanBlocks(at, end, [&](const char* block, const BlockBits& bits)
+	{
+		for (uint64_t ops = bits.op; ops; ops &= ops - 1)
+		{
+			const uint32_t i = lowestBitIndex(ops);
+			const char c = bits.bytes[i];
+
+			if (c == '[' || c == '{')
+			{
+				depth++;
+			}
+			else if (c == ']' || c == '}')
+			{
+				if (depth == 0)
+				{
+					closed = true;
+					cut(block + i);
+					return false;
+				}
+
+				depth--;
+			}
+			else if (c == ',' && depth == 0 && (size_t)(block + i - chunkAt) >= ARRAY_CHUNK_SIZE)
+			{
+				cut(block + i);
+			}
+		}
+
+		return true;
+	});
+
+	if (!closed) return false;
+
+	// a trailing comma was cut off the chunk before, the array would parse without it
+	const ArrayChunk& last = chunks.back();
+	size_t newlines = 0;
+	return chunks.size() == 1 || kernels.skipWhitespace(last.at, last.at + last.length, newlines) != last.at + last.length;
+}
+
+void parseArrayChunk(ArrayChunk& chunk, unsigned int flags)
+{
+	const size_t pushed = errors.pushed;
+
+	// the elements are parsed as an array of their own
+	std::string text;
+	text.reserve(chunk.length + 2);
+	text += '[';
+	text.append(chunk.at, chunk.length);
+	text += ']';
+
+	ParseContext ctx = {};
+	const char* raw = openParseContext(ctx, text.data(), text.size(), flags);
+	chunk.array = parseRootArray(ctx, raw, text.size());
+
+	if (errors.pushed != pushed) takeErrors(pushed, chunk.errors);
+}
+
+pj_Array* parseArrayParallel(const char* raw, size_t length, unsigned int flags, unsigned int threadCount)
+{
+	const ScanKernels& kernels = scanKernels();
+	const char* const end = raw + length;
+
+	size_t lineNo = 0;
+	const char* at = kernels.skipWhitespace(raw, end, lineNo);
+
+	std::vector<ArrayChunk> chunks;
+	if (at == end || *at != '[' || !splitArrayChunks(at + 1, end, lineNo, chunks) || chunks.size() < 2)
+	{
+		// nothing to split, errors included, which are best reported by the parser itself
+		ParseContext ctx = {};
+		return parseRootArray(ctx, openParseContext(ctx, raw, length, flags), length);
+	}
+
+	runParallel(chunks.size(), threadCount, [&](size_t task)
+	{
+		parseArrayChunk(chunks[task], flags);
+	});
+
+	// the first chunk's array becomes the result, the others are moved into it
+	pj_Array* array = chunks[0].array;
+	// its text covers the first chunk only
+	array->source = nullptr;
+
+	size_t size = 0;
+	for (const ArrayChunk& chunk : chunks) size += chunk.array->size;
+	reserveArray(*array, size);
+
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		ArrayChunk& chunk = chunks[i];
+
+		if (i > 0)
+		{
+			for (size_t j = 0; j < chunk.array->size; j++)
+			{
+				new (&array->items[array->size++]) JsonVal(std::move(chunk.array->items[j]));
+				chunk.array->items[j].~JsonVal();
+			}
+			chunk.array->size = 0;
+
+			if (chunk.array->arena)
+				array->arena->adoptedArenas.push_back(chunk.array->arena);
+			else
+				pj_deleteArray(chunk.array);
+		}
+
+		if (chunk.errors.empty()) continue;
+
+		pushTakenErrors(chunk.errors, "ARRAY", "CHUNK LINENO", chunk.lineNo);
+
+		// like a serial parse, stop at the first error
+		for (size_t j = i + 1; j < chunks.size(); j++) pj_deleteArray(chunks[j].array);
+		break;
+	}
+
+	return array;
+}
+
+bool takeTask(WorkRange& range, size_t& task)
+{
+	std::lock_guard<std::mutex> guard(range.lock);
+	if (range.begin == range.end) return false;
+
+	task = range.begin++;
+	return true;
+}
+
+// moves the back half of the largest range left to the one of self, false once all are empty
+bool stealTasks(WorkRange* ranges, unsigned int threadCount, unsigned int self)
+{
+	for (;;)
+	{
+		unsigned int victim = self;
+		size_t most = 0;
+
+		for (unsigned int i = 0; i < threadCount; i++)
+		{
+			if (i == self) continue;
+
+			std::lock_guard<std::mutex> guard(ranges[i].lock);
+			if (ranges[i].end - ranges[i].begin > most)
+			{
+				most = ranges[i].end - ranges[i].begin;
+				victim = i;
+			}
+		}
+
+		if (victim == self) return false;
+
+		size_t begin, end;
+		{
+			std::lock_guard<std::mutex> guard(ranges[victim].lock);
+
+			// someone else got there first, look again
+			if (ranges[victim].begin == ranges[victim].end) continue;
+
+			end = ranges[victim].end;
+			begin = end - (end - ranges[victim].begin + 1) / 2;
+			ranges[victim].end = begin;
+		}
+
+		std::lock_guard<std::mutex> guard(ranges[self].lock);
+		ranges[self].begin = begin;
+		ranges[self].end = end;
+		return true;
+	}
+}
+
+pj_Object* createObj(Arena* arena)
 {
-	return getArrayValue<pj_Object*, PJ_VALUE_OBJ>(array, index);
+	if (arena) return arena->create<pj_Object>(arena);
+
+	return new pj_Object(nullptr);
 }
 
-EXTERN_C void pj_arrayAddNum(pj_Array * array, double num)
+pj_Array* createArray(Arena* arena)
 {
-	assert(array != nullptr);
+	pj_Array* array = arena ? arena->create<pj_Array>() : new pj_Array();
 
-	JsonVal val;
-	val.type = PJ_VALUE_NUMBER;
-	val.num = num;
+	array->items = nullptr;
+	array->capacity = 0;
+	array->size = 0;
+	array->arena = arena;
+	array->source = nullptr;
 
-	addArrayValue(*array, std::move(val));
+	return array;
 }
 
-EXTERN_C void pj_arrayAddBool(pj_Array * array, pj_boolean boolean)
+char* allocString(Arena* arena, size_t length)
 {
-	assert(array != nullptr);
+	if (arena) return (char*)arena->resource.allocate(length + 1, 1);
 
-	JsonVal val;
-	val.type = PJ_VALUE_BOOL;
-	val.boolean = boolean;
+	return new char[length + 1];
+}
 
-	addArrayValue(*array, std::move(val));
+char* parseCString(ParseContext& ctx, const Token& token, size_t* outLength)
+{
+	// the tokenizer already found both quotes, no need to scan for them again
+	const char* begin = token.str + 1;
+	const char* end = token.str + token.length - 1;
+
+	// in situ the decoded string overwrites its source and the closing quote becomes the terminator
+	char* result = ctx.inSitu ? const_cast<char*>(begin) : allocString(ctx.arena, end - begin);
+	size_t length = end - begin;
+
+	if (token.hasEscapes)
+		length = decodeString(begin, end, result);
+	else if (!ctx.inSitu)
+		memcpy(result, begin, length);
+
+	result[length] = 0;
+
+	if (outLength) *outLength = length;
+	return result;
 }
 
-EXTERN_C void pj_arrayAddString(pj_Array * array, const char * str)
+// position is where the key lands in its object
+char* parseKeyString(ParseContext& ctx, const Token& token, uint32_t position, size_t* outLength)
 {
-	assert(array != nullptr);
+	if (!ctx.arena || !ctx.arena->internKeys) return parseCString(ctx, token, outLength);
 
-	JsonVal val;
-	val.type = PJ_VALUE_STRING;
-	val.string = cpyStringDynamic(str);
+	const char* begin = token.str + 1;
+	const char* end = token.str + token.length - 1;
+	const char* interned;
+
+	// a key seen before costs a lookup and no allocation, unless it has to be decoded first
+	if (!token.hasEscapes)
+	{
+		const size_t length = end - begin;
+		const char* recent = position < SMALL_OBJECT_SIZE ? ctx.recentKeys[position] : nullptr;
+
+		if (recent && internedHeader(recent).length == length && memcmp(recent, begin, length) == 0)
+			interned = recent;
+		else
+			interned = internKey(*ctx.arena, begin, length);
+	}
+	else
+	{
+		std::string decoded(end - begin, 0);
+		decoded.resize(decodeString(begin, end, &decoded[0]));
+		interned = internKey(*ctx.arena, decoded.data(), decoded.size());
+	}
+
+	if (position < SMALL_OBJECT_SIZE) ctx.recentKeys[position] = interned;
+
+	*outLength = internedHeader(interned).length;
+	return const_cast<char*>(interned);
+}
 
+void appendArrayValue(pj_Array* array, JsonVal&& val)
+{
+	markModified(array->source);
 	addArrayValue(*array, std::move(val));
 }
 
-EXTERN_C void pj_arrayAddArray(pj_Array * array, pj_Array * other)
+void adoptValue(Arena* arena, JsonVal& val)
 {
-	assert(array != nullptr);
+	if (!arena) return;
 
-	JsonVal val;
-	val.type = PJ_VALUE_ARRAY;
-	val.array = other;
+	// nodes from outside the document are handed to the arena so they die with it
+	switch (val.type)
+	{
+	case PJ_VALUE_OBJ:
+		if (val.obj && val.obj->arena != arena && !val.isBorrowed)
+			arena->adoptedObjects.push_back(val.obj);
+		break;
+	case PJ_VALUE_ARRAY:
+		if (val.array && val.array->arena != arena && !val.isBorrowed)
+			arena->adoptedArrays.push_back(val.array);
+		break;
+	default:
+		break;
+	}
 
-	addArrayValue(*array, std::move(val));
+	val.isBorrowed = true;
 }
 
-EXTERN_C void pj_arrayAddObj(pj_Array * array, pj_Object * obj)
+void setObjectValue(pj_Object* obj, const char* propName, JsonVal&& val)
 {
-	assert(array != nullptr);
+	assert(obj != nullptr);
 
-	JsonVal val;
-	val.type = PJ_VALUE_OBJ;
-	val.obj = obj;
+	adoptValue(obj->arena, val);
+	markModified(obj->source);
 
-	addArrayValue(*array, std::move(val));
+	if (JsonProp* prop = findProp(*obj, propName))
+	{
+		prop->val = std::move(val);
+		return;
+	}
+
+	const size_t nameLength = strlen(propName);
+	const char* name = internsKeys(*obj) ? internKey(*obj->arena, propName, nameLength) : cpyStringDynamic(propName, obj->arena);
+
+	insertEntry(*obj, name, nameLength).prop.val = std::move(val);
 }
 
-EXTERN_C void pj_arrayAddNull(pj_Array * array)
+void builderError(pj_Builder& builder, const char* message)
 {
-	assert(array != nullptr);
+	using namespace std::string_literals;
+	errors.push("BUILDER :: "s + message);
+	builder.misused = true;
+}
 
-	JsonVal val;
-	val.type = PJ_VALUE_NULL;
+// comma, line break and indentation in front of the next member of the innermost scope
+void builderSeparate(pj_Builder& builder)
+{
+	pj_Builder::Scope& scope = builder.scopes.back();
+	if (scope.count++) builder.out.put(',');
 
-	addArrayValue(*array, std::move(val));
+	if (builder.isPretty)
+	{
+		builder.out.put('\n');
+		builder.out.indent((int)builder.scopes.size());
+	}
+}
+
+bool beginBuilderValue(pj_Builder& builder)
+{
+	if (builder.misused) return false;
+
+	if (builder.scopes.empty())
+	{
+		if (!builder.done) return true;
+
+		builderError(builder, "Only one root value can be written");
+		return false;
+	}
+
+	if (!builder.scopes.back().isObject)
+	{
+		builderSeparate(builder);
+		return true;
+	}
+
+	if (!builder.hasKey)
+	{
+		builderError(builder, "Object member is missing its key");
+		return false;
+	}
+
+	builder.hasKey = false;
+	return true;
+}
+
+void endBuilderValue(pj_Builder& builder)
+{
+	if (builder.scopes.empty()) builder.done = true;
+}
+
+void endBuilderScope(pj_Builder& builder, bool isObject)
+{
+	if (builder.misused) return;
+
+	if (builder.scopes.empty() || builder.scopes.back().isObject != isObject || builder.hasKey)
+	{
+		builderError(builder, isObject ? "Unbalanced pj_builderEndObject" : "Unbalanced pj_builderEndArray");
+		return;
+	}
+
+	const bool isEmpty = builder.scopes.back().count == 0;
+	builder.scopes.pop_back();
+
+	if (builder.isPretty && !isEmpty)
+	{
+		builder.out.put('\n');
+		builder.out.indent((int)builder.scopes.size());
+	}
+
+	builder.out.put(isObject ? '}' : ']');
+	endBuilderValue(builder);
+}
+
+void saxError(pj_SaxParser& parser, const char* message)
+{
+	using namespace std::string_literals;
+	errors.push("SAX :: "s + message + "; LINENO: " + std::to_string(parser.lineNo));
+	parser.failed = true;
+}
+
+void appendSaxInput(pj_SaxParser& parser, const char* data, size_t length)
+{
+	std::vector<char>& buffer = parser.buffer;
+
+	if (!buffer.empty()) buffer.pop_back();
+
+	// drop the consumed input once that frees more than it has to move
+	if (parser.start && parser.start >= buffer.size() / 2)
+	{
+		buffer.erase(buffer.begin(), buffer.begin() + parser.start);
+		if (parser.resume) parser.resume -= parser.start;
+		parser.start = 0;
+	}
+
+	buffer.insert(buffer.end(), data, data + length);
+	buffer.push_back(0);
+}
+
+void runSaxParser(pj_SaxParser& parser, bool isFinal)
+{
+	if (parser.buffer.empty()) return;
+
+	const ScanKernels& kernels = scanKernels();
+	char* const data = parser.buffer.data();
+	const char* const end = data + parser.buffer.size() - 1;
+
+	while (!parser.failed)
+	{
+		char* at = const_cast<char*>(kernels.skipWhitespace(data + parser.start, end, parser.lineNo));
+		parser.start = at - data;
+
+		if (at == end) return;
+
+		Token token;
+		if (!nextSaxToken(parser, at, isFinal, token)) return;
+
+		parser.start = (token.str + token.length) - data;
+		handleSaxToken(parser, token);
+	}
+}
+
+// false when the token at 'at' continues past the end of the buffer, or is invalid
+bool nextSaxToken(pj_SaxParser& parser, char* at, bool isFinal, Token& token)
+{
+	char* const data = parser.buffer.data();
+	const char* const end = data + parser.buffer.size() - 1;
+
+	token = {};
+	token.str = at;
+	token.length = 1;
+
+	switch (*at)
+	{
+	case '{': token.type = Token::OPEN_BRACE;           return true;
+	case '}': token.type = Token::CLOSE_BRACE;          return true;
+	case ':': token.type = Token::COLON;                return true;
+	case ',': token.type = Token::COMMA;                return true;
+	case '[': token.type = Token::SQUARE_BRACKET_OPEN;  return true;
+	case ']': token.type = Token::SQUARE_BRACKET_CLOSE; return true;
+	case '"':
+	{
+		const ScanKernels& kernels = scanKernels();
+		const char* scan = parser.resume ? data + parser.resume : at + 1;
+
+		for (;;)
+		{
+			scan = kernels.findQuoteOrEscape(scan, end);
+			if (*scan == '"') break;
+
+			if (scan == end || (*scan == '\\' && scan + 1 == end))
+			{
+				if (isFinal)
+				{
+					saxError(parser, "Unterminated string");
+					return false;
+				}
+
+				parser.resume = scan - data;
+				return false;
+			}
+
+			if (*scan == 0)
+			{
+				saxError(parser, "NUL character in string");
+				return false;
+			}
+
+			parser.resumeHasEscapes = true;
+			scan += 2;
+		}
+
+		token.type = Token::STRING;
+		token.length = (int)(scan - at) + 1;
+		token.hasEscapes = parser.resumeHasEscapes;
+
+		parser.resume = 0;
+		parser.resumeHasEscapes = false;
+		return true;
+	}
+	default:
+	{
+		// numbers and literals run up to the next delimiter, which may still be on its way
+		const char* run = at;
+		while (run < end && (isalnum((unsigned char)*run) || *run == '-' || *run == '+' || *run == '.'))
+			run++;
+
+		if (run == end && !isFinal) return false;
+
+		if (isDigit(*at) || *at == '-')
+			token = parseNumToken(at, end);
+		else if (*at == 't' || *at == 'f' || *at == 'n')
+			token = parseAlNumLiteralToken(at, end);
+		else
+			token = unknownToken();
+
+		if (token.type == Token::UNKNOWN || at + token.length != run)
+		{
+			saxError(parser, "Invalid number or literal");
+			return false;
+		}
+
+		return true;
+	}
+	}
+}
+
+void handleSaxToken(pj_SaxParser& parser, Token& token)
+{
+	switch (parser.state)
+	{
+	case pj_SaxParser::VALUE_OR_END:
+		if (token.type == Token::SQUARE_BRACKET_CLOSE)
+		{
+			parser.scopes.pop_back();
+			if (parser.callbacks.endArray) parser.callbacks.endArray(parser.userData);
+			endSaxValue(parser);
+			return;
+		}
+		// fallthrough
+	case pj_SaxParser::VALUE:
+		saxValue(parser, token);
+		return;
+	case pj_SaxParser::KEY_OR_END:
+		if (token.type == Token::CLOSE_BRACE)
+		{
+			parser.scopes.pop_back();
+			if (parser.callbacks.endObject) parser.callbacks.endObject(parser.userData);
+			endSaxValue(parser);
+			return;
+		}
+		// fallthrough
+	case pj_SaxParser::KEY:
+	{
+		if (token.type != Token::STRING)
+		{
+			saxError(parser, "Expected property name");
+			return;
+		}
+
+		// the buffer is ours, so keys and strings are decoded where they are
+		char* begin = const_cast<char*>(token.str) + 1;
+		const char* end = token.str + token.length - 1;
+		const size_t length = token.hasEscapes ? decodeString(begin, end, begin) : end - begin;
+		begin[length] = 0;
+
+		if (parser.callbacks.key) parser.callbacks.key(parser.userData, begin, length);
+		parser.state = pj_SaxParser::COLON;
+		return;
+	}
+	case pj_SaxParser::COLON:
+		if (token.type != Token::COLON)
+		{
+			saxError(parser, "Expected Colon after property name");
+			return;
+		}
+
+		parser.state = pj_SaxParser::VALUE;
+		return;
+	case pj_SaxParser::COMMA_OR_END:
+	{
+		const bool isObject = parser.scopes.back();
+
+		if (token.type == Token::COMMA)
+		{
+			parser.state = isObject ? pj_SaxParser::KEY : pj_SaxParser::VALUE;
+		}
+		else if (token.type == (isObject ? Token::CLOSE_BRACE : Token::SQUARE_BRACKET_CLOSE))
+		{
+			parser.scopes.pop_back();
+
+			if (isObject && parser.callbacks.endObject) parser.callbacks.endObject(parser.userData);
+			if (!isObject && parser.callbacks.endArray) parser.callbacks.endArray(parser.userData);
+
+			endSaxValue(parser);
+		}
+		else
+		{
+			saxError(parser, isObject ? "Missing comma after property value" : "Missing comma after array element");
+		}
+
+		return;
+	}
+	case pj_SaxParser::DONE:
+		saxError(parser, "Unexpected data after the root value");
+		return;
+	}
+}
+
+void saxValue(pj_SaxParser& parser, Token& token)
+{
+	const pj_SaxCallbacks& callbacks = parser.callbacks;
+
+	switch (token.type)
+	{
+	case Token::OPEN_BRACE:
+		if (callbacks.startObject) callbacks.startObject(parser.userData);
+		parser.scopes.push_back(true);
+		parser.state = pj_SaxParser::KEY_OR_END;
+		return;
+	case Token::SQUARE_BRACKET_OPEN:
+		if (callbacks.startArray) callbacks.startArray(parser.userData);
+		parser.scopes.push_back(false);
+		parser.state = pj_SaxParser::VALUE_OR_END;
+		return;
+	case Token::STRING:
+	{
+		char* begin = const_cast<char*>(token.str) + 1;
+		const char* end = token.str + token.length - 1;
+		const size_t length = token.hasEscapes ? decodeString(begin, end, begin) : end - begin;
+		begin[length] = 0;
+
+		if (callbacks.string) callbacks.string(parser.userData, begin, length);
+		break;
+	}
+	case Token::NUMBER:
+	{
+		double num;
+		int64_t integer;
+
+		if (!parseNumber(token.str, token.length, num, integer))
+		{
+			if (callbacks.number) callbacks.number(parser.userData, num);
+		}
+		else if (callbacks.int64)
+		{
+			callbacks.int64(parser.userData, integer);
+		}
+		else if (callbacks.number)
+		{
+			callbacks.number(parser.userData, (double)integer);
+		}
+
+		break;
+	}
+	case Token::BOOL:
+		if (callbacks.boolean) callbacks.boolean(parser.userData, token.str[0] == 't');
+		break;
+	case Token::JSON_NULL:
+		if (callbacks.null) callbacks.null(parser.userData);
+		break;
+	default:
+		saxError(parser, "Value Token of unknown or unspecified type");
+		return;
+	}
+
+	endSaxValue(parser);
+}
+
+void endSaxValue(pj_SaxParser& parser)
+{
+	parser.state = parser.scopes.empty() ? pj_SaxParser::DONE : pj_SaxParser::COMMA_OR_END;
+}
+
+JsonProp* findProp(pj_Object& obj, const char* propName)
+{
+	ObjectEntry* entry = findEntry(obj, propName, strlen(propName));
+	return entry ? &entry->prop : nullptr;
 }
 
-EXTERN_C void pj_objSetNum(pj_Object * obj, const char * propName, double num)
+ObjectEntry* findEntry(pj_Object& obj, const char* key, size_t keyLength)
 {
-	JsonProp prop;
-	prop.name = propName;
-	prop.val.type = PJ_VALUE_NUMBER;
-	prop.val.num = num;
-
-	obj->data[propName] = std::move(prop);
+	return findEntry(obj, key, keyLength, obj.index ? hashKey(key, keyLength) : 0);
 }
 
-EXTERN_C void pj_objSetBool(pj_Object * obj, const char * propName, pj_boolean boolean)
+// hash is only used by objects with an index
+ObjectEntry* findEntry(pj_Object& obj, const char* key, size_t keyLength, uint32_t hash)
 {
-	JsonProp prop;
-	prop.name = propName;
-	prop.val.type = PJ_VALUE_BOOL;
-	prop.val.boolean = boolean;
+	// interned keys often come back as the very same pointer, which needs no compare
+	if (!obj.index)
+	{
+		for (uint32_t i = 0; i < obj.size; i++)
+		{
+			ObjectEntry& entry = obj.entries[i];
+			if (entry.key == key || (entry.keyLength == keyLength && memcmp(entry.key, key, keyLength) == 0)) return &entry;
+		}
 
-	obj->data[propName] = std::move(prop);
-}
+		return nullptr;
+	}
 
-EXTERN_C void pj_objSetString(pj_Object * obj, const char * propName, const char * str)
-{
-	JsonProp prop;
-	prop.name = propName;
-	prop.val.type = PJ_VALUE_NUMBER;
+	const uint32_t mask = obj.indexCapacity - 1;
 
-	prop.val.string = cpyStringDynamic(str);
+	for (uint32_t slot = hash & mask; obj.index[slot]; slot = (slot + 1) & mask)
+	{
+		ObjectEntry& entry = obj.entries[obj.index[slot] - 1];
+		if (entry.key == key || (entry.hash == hash && entry.keyLength == keyLength && memcmp(entry.key, key, keyLength) == 0))
+			return &entry;
+	}
 
-	obj->data[propName] = std::move(prop);
+	return nullptr;
 }
 
-EXTERN_C void pj_objSetArray(pj_Object * obj, const char * propName, pj_Array * array)
+// keys of a document with a dictionary are equal exactly when their pointers are
+ObjectEntry* findInternedEntry(pj_Object& obj, const char* key)
 {
-	JsonProp prop;
-	prop.name = propName;
-	prop.val.type = PJ_VALUE_ARRAY;
-	prop.val.array = array;
+	if (!obj.index)
+	{
+		for (uint32_t i = 0; i < obj.size; i++)
+		{
+			if (obj.entries[i].key == key) return &obj.entries[i];
+		}
 
-	obj->data[propName] = std::move(prop);
-}
+		return nullptr;
+	}
 
-EXTERN_C void pj_objSetObj(pj_Object * obj, const char * propName, pj_Object * other)
-{
-	JsonProp prop;
-	prop.name = propName;
-	prop.val.type = PJ_VALUE_OBJ;
-	prop.val.obj = other;
+	const uint32_t mask = obj.indexCapacity - 1;
+
+	for (uint32_t slot = internedHeader(key).hash & mask; obj.index[slot]; slot = (slot + 1) & mask)
+	{
+		ObjectEntry& entry = obj.entries[obj.index[slot] - 1];
+		if (entry.key == key) return &entry;
+	}
 
-	obj->data[propName] = std::move(prop);
+	return nullptr;
 }
 
-EXTERN_C void pj_objSetNull(pj_Object * obj, const char * propName)
+// appends a member that is known not to exist yet, the object takes over key
+ObjectEntry& insertEntry(pj_Object& obj, const char* key, size_t keyLength)
 {
-	JsonProp prop;
-	prop.name = propName;
-	prop.val.type = PJ_VALUE_NULL;
+	if (obj.size == obj.capacity)
+		reallocateEntries(obj, obj.capacity ? obj.capacity * 2 : MIN_OBJECT_CAPACITY);
 
-	obj->data[propName] = std::move(prop);
-}
+	const uint32_t position = obj.size++;
 
+	ObjectEntry& entry = obj.entries[position];
+	entry.key = key;
+	entry.keyLength = (uint32_t)keyLength;
+	entry.hash = 0;
+	new (&entry.prop) JsonProp();
 
-EXTERN_C pj_ValueType pj_getObjPropType(pj_Object * obj, const char * propName)
-{
-	assert(obj != nullptr);
+	if (obj.index)
+	{
+		entry.hash = entryHash(obj, key, keyLength);
 
-	if (JsonProp* prop = findProp(*obj, propName))
+		if (obj.size * 2 > obj.indexCapacity)
+			rebuildObjectIndex(obj, obj.indexCapacity * 2);
+		else
+			indexEntry(obj, position);
+	}
+	else if (obj.size > SMALL_OBJECT_SIZE)
 	{
-		return prop->val.type;
+		rebuildObjectIndex(obj, SMALL_OBJECT_SIZE * 4);
 	}
 
-	return PJ_VALUE_NULL;
+	return entry;
 }
 
-EXTERN_C pj_ValueType pj_getArrayElemType(pj_Array * array, size_t index)
+void reallocateEntries(pj_Object& obj, uint32_t capacity)
 {
-	assert(index >= 0 && index <= array->size);
-	JsonVal& val = array->items[index];
-	return val.type;
-}
+	std::pmr::memory_resource* resource = resourceOf(obj.arena);
+	ObjectEntry* newEntries = (ObjectEntry*)resource->allocate(capacity * sizeof(ObjectEntry), alignof(ObjectEntry));
 
-EXTERN_C pj_boolean pj_isArrayElemOfType(pj_Array * array, size_t index, pj_ValueType type)
-{
-	assert(index > 0 && index < array->size);
-	return array->items[index].type == type;
+	for (uint32_t i = 0; i < obj.size; i++)
+	{
+		ObjectEntry& from = obj.entries[i];
+		ObjectEntry& to = newEntries[i];
+
+		to.key = from.key;
+		to.keyLength = from.keyLength;
+		to.hash = from.hash;
+		new (&to.prop) JsonProp(std::move(from.prop));
+		from.prop.~JsonProp();
+	}
+
+	if (obj.entries)
+		resource->deallocate(obj.entries, obj.capacity * sizeof(ObjectEntry), alignof(ObjectEntry));
+
+	obj.entries = newEntries;
+	obj.capacity = capacity;
 }
 
-EXTERN_C pj_boolean pj_isObjPropOfType(pj_Object * obj, const char * propName, pj_ValueType type)
+void rebuildObjectIndex(pj_Object& obj, uint32_t indexCapacity)
 {
-	if (JsonProp* prop = findProp(*obj, propName))
+	std::pmr::memory_resource* resource = resourceOf(obj.arena);
+
+	// hashes are computed once, when the index is first built
+	if (!obj.index)
+	{
+		for (uint32_t i = 0; i < obj.size; i++)
+			obj.entries[i].hash = entryHash(obj, obj.entries[i].key, obj.entries[i].keyLength);
+	}
+	else
 	{
-		return prop->val.type == type;
+		resource->deallocate(obj.index, obj.indexCapacity * sizeof(uint32_t), alignof(uint32_t));
 	}
 
-	return false;
+	obj.index = (uint32_t*)resource->allocate(indexCapacity * sizeof(uint32_t), alignof(uint32_t));
+	obj.indexCapacity = indexCapacity;
+	memset(obj.index, 0, indexCapacity * sizeof(uint32_t));
+
+	for (uint32_t i = 0; i < obj.size; i++)
+		indexEntry(obj, i);
 }
 
-EXTERN_C void pj_objForEachKey(pj_Object * obj, void(*callback)(pj_Object*, const char *))
+void indexEntry(pj_Object& obj, uint32_t position)
 {
-	for (auto& kv : obj->data)
-		callback(obj, kv.first.c_str());
+	const uint32_t mask = obj.indexCapacity - 1;
+
+	uint32_t slot = obj.entries[position].hash & mask;
+	while (obj.index[slot]) slot = (slot + 1) & mask;
+
+	obj.index[slot] = position + 1;
 }
 
-EXTERN_C size_t pj_getArraySize(pj_Array* array)
+uint32_t hashKey(const char* key, size_t length)
 {
-	return array->size;
+	// FNV-1a, keys are short and mostly ASCII
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+
+	return hash;
 }
 
-EXTERN_C const char* pj_popError()
+uint32_t entryHash(const pj_Object& obj, const char* key, size_t keyLength)
 {
-	const std::string& error = errors.pop();
-	return error.size() == 0 ? nullptr : error.c_str();
+	return internsKeys(obj) ? internedHeader(key).hash : hashKey(key, keyLength);
 }
 
-void parseJSONObject(Cursor& cursor, pj_Object * json)
+// returns the dictionary copy of key, adding one on first sight
+const char* internKey(Arena& arena, const char* key, size_t length)
 {
-	using namespace std::string_literals;
-	bool done = false;
+	const uint32_t hash = hashKey(key, length);
+	if (const char* interned = findInternedKey(arena, key, length, hash)) return interned;
 
+	std::vector<const char*>& slots = arena.keySlots;
+
+	if ((arena.keyCount + 1) * 2 > slots.size())
 	{
-		PeekToken pt = peekToken(cursor);
-		if (pt.token.type == Token::CLOSE_BRACE)
+		std::vector<const char*> grown(slots.empty() ? 64 : slots.size() * 2, nullptr);
+		const size_t mask = grown.size() - 1;
+
+		for (const char* existing : slots)
 		{
-			// empty object, advance cursor and bail
-			cursor = pt.futureCursor;
-			return;
+			if (!existing) continue;
+
+			size_t slot = internedHeader(existing).hash & mask;
+			while (grown[slot]) slot = (slot + 1) & mask;
+			grown[slot] = existing;
 		}
+
+		slots.swap(grown);
 	}
 
-	while (!done && *cursor.at != NULL)
-	{
-		Token t = getToken(cursor);
+	InternedKey* header = (InternedKey*)arena.resource.allocate(sizeof(InternedKey) + length + 1, alignof(InternedKey));
+	header->hash = hash;
+	header->length = (uint32_t)length;
 
-		if (t.type == Token::STRING)
-		{
-			Token colon = getToken(cursor);
+	char* copy = (char*)(header + 1);
+	memcpy(copy, key, length);
+	copy[length] = 0;
 
-			if (colon.type == Token::COLON)
-			{
-				std::string propName = parseString(t.str);
-				Token val = getToken(cursor);
+	const size_t mask = slots.size() - 1;
+	size_t slot = hash & mask;
+	while (slots[slot]) slot = (slot + 1) & mask;
 
-				JsonProp jprop = {};
-				jprop.name = propName;
+	slots[slot] = copy;
+	arena.keyCount++;
+	return copy;
+}
 
-				if (!parseJSONValue(cursor, val, jprop.val))
-				{
-					// TODO: ERROR HANDLING
-					return;
-				}
+const char* findInternedKey(const Arena& arena, const char* key, size_t length, uint32_t hash)
+{
+	const std::vector<const char*>& slots = arena.keySlots;
+	if (slots.empty()) return nullptr;
 
-				json->data.emplace(propName, std::move(jprop));
+	const size_t mask = slots.size() - 1;
 
-				PeekToken comma = peekToken(cursor);
-				if (comma.token.type != Token::COMMA)
-				{
-					errors.push("PARSER :: Missing comma after property value; LINENO: "s + std::to_string(cursor.lineNo));
-					return;
-				}
+	for (size_t slot = hash & mask; slots[slot]; slot = (slot + 1) & mask)
+	{
+		const char* interned = slots[slot];
+		const InternedKey& header = internedHeader(interned);
 
-			}
-			else
-			{
-				errors.push("PARSER :: Expected Colon after property name; LINENO: "s + std::to_string(cursor.lineNo));
-				break;
-				// TODO: ERROR
-			}
-		}
-		else if (t.type == Token::CLOSE_BRACE)
-		{
-			done = true;
-		}
+		if (header.hash == hash && header.length == length && memcmp(interned, key, length) == 0)
+			return interned;
 	}
+
+	return nullptr;
 }
 
-void parseJSONArray(Cursor & cursor, pj_Array * array)
+// a leading '/' makes str a JSON Pointer, anything else is a dotted path
+bool compilePath(pj_Path& path, const char* str)
 {
-	{
-		PeekToken pt = peekToken(cursor);
-		if (pt.token.type == Token::SQUARE_BRACKET_CLOSE)
-		{
-			// empty array, advance cursor and bail
-			cursor = pt.futureCursor;
-			return;
-		}
-	}
+	const char* const source = str;
+	const bool isPointer = *str == '/';
+	const char separator = isPointer ? '/' : '.';
+	if (isPointer) str++;
 
-	while (*cursor.at != NULL)
+	std::vector<size_t> offsets;
+
+	for (;;)
 	{
-		Token item = getToken(cursor);
-		JsonVal val = {};
+		const char* end = strchr(str, separator);
+		if (!end) end = str + strlen(str);
+
+		offsets.push_back(path.keys.size());
 
-		if (!parseJSONValue(cursor, item, val))
+		for (const char* c = str; c < end; c++)
 		{
-			// TODO: ERROR HANDLING
-			return;
-		}
+			if (!isPointer || *c != '~')
+			{
+				path.keys += *c;
+				continue;
+			}
 
-		addArrayValue(*array, std::move(val));
+			// ~0 and ~1 are the only escapes of a pointer
+			if (c + 1 == end || (c[1] != '0' && c[1] != '1'))
+			{
+				using namespace std::string_literals;
+				errors.push("PATH :: Invalid escape in JSON Pointer; PATH: "s + source);
+				return false;
+			}
 
-		Token next = getToken(cursor);
-		if (next.type == Token::SQUARE_BRACKET_CLOSE)
-		{
-			break; // done
-		}
-		else if (next.type != Token::COMMA)
-		{
-			using namespace std::string_literals;
-			errors.push("PARSER :: Missing comma after array element; LINENO: "s + std::to_string(cursor.lineNo));
-			break;
-			// TODO: ERROR
+			path.keys += *++c == '0' ? '~' : '/';
 		}
+
+		path.keys += '\0';
+
+		if (!*end) break;
+		str = end + 1;
 	}
-}
 
-bool parseJSONValue(Cursor & cursor, Token & valueToken, JsonVal & val)
-{
-	switch (valueToken.type)
+	// the keys are only pointed into once the buffer stopped growing
+	for (const size_t offset : offsets)
 	{
-	case Token::BOOL:
-		val.type = PJ_VALUE_BOOL;
+		pj_Path::Segment segment;
+		segment.key = path.keys.data() + offset;
+		segment.keyLength = (uint32_t)strlen(segment.key);
+		segment.hash = hashKey(segment.key, segment.keyLength);
+		segment.index = pj_Path::NO_INDEX;
 
-		if (cmpSubStr(valueToken.str, "false", valueToken.length))
-		{
-			val.boolean = false;
-		}
-		else if (cmpSubStr(valueToken.str, "true", valueToken.length))
-		{
-			val.boolean = true;
-		}
+		// array indices have no leading zeros, like in JSON Pointers
+		const bool isIndex = segment.keyLength > 0 && segment.keyLength < 19 &&
+			(segment.key[0] != '0' || segment.keyLength == 1) &&
+			strspn(segment.key, "0123456789") == segment.keyLength;
 
-		break;
-	case Token::NUMBER:
-		val.type = PJ_VALUE_NUMBER;
-		char buffer[255];
-		memcpy(buffer, valueToken.str, valueToken.length);
-		val.num = atof(buffer);
-		break;
-	case Token::STRING:
-		val.type = PJ_VALUE_STRING;
-		val.string = parseCString(valueToken.str);
-		break;
-	case Token::JSON_NULL:
-		val.type = PJ_VALUE_NULL;
-		break;
-	case Token::SQUARE_BRACKET_OPEN:
-		val.type = PJ_VALUE_ARRAY;
-		val.array = pj_createArray();
-		parseJSONArray(cursor, val.array);
-		break;
-	case Token::OPEN_BRACE:
-		val.type = PJ_VALUE_OBJ;
-		val.obj = pj_createObj();
-		parseJSONObject(cursor, val.obj);
-		break;
-	default:
-		using namespace std::string_literals;
-		errors.push("PARSER :: Value Token of unknown or unspecified type; LINENO: "s + std::to_string(cursor.lineNo));
-		return false;
+		if (isIndex) segment.index = (size_t)strtoull(segment.key, nullptr, 10);
+
+		path.segments.push_back(segment);
 	}
 
 	return true;
 }
 
-char * objectToString(pj_Object * obj, int depth, pj_boolean isPretty)
+// one of obj and array is the root, returns null if any segment is missing
+JsonVal* findPathValue(pj_Object* obj, pj_Array* array, const pj_Path& path)
 {
-	char* result = new char[3]();
-
-	result[0] = '{';
-	if (isPretty) result[1] = '\n';
+	JsonVal* val = nullptr;
 
-	const size_t objSize = obj->data.size();
-	int current = -1;
-
-	for (auto& kv : obj->data)
+	for (const pj_Path::Segment& segment : path.segments)
 	{
-		if (isPretty)
-		{
-			for (int i = 0; i < depth + 1; i++)
-				moveConcatString(result, INDENT);
-		}
-
-		moveConcatPropName(result, kv.first.c_str());
+		val = findSegmentValue(obj, array, segment);
+		if (!val) return nullptr;
 
-		moveConcatString(result, valueToString(kv.second.val, depth, isPretty));
-		const bool isLast = ++current == objSize - 1;
-
-		if (!isLast)
-		{
-			moveConcatString(result, ",");
-			if (isPretty) moveConcatString(result, "\n");
-		}
+		materializeValue(*val);
+		obj = val->type == PJ_VALUE_OBJ ? val->obj : nullptr;
+		array = val->type == PJ_VALUE_ARRAY ? val->array : nullptr;
 	}
 
-	if (isPretty)
+	return val;
+}
+
+// obj and array may both be null when the parent is a scalar
+JsonVal* findSegmentValue(pj_Object* obj, pj_Array* array, const pj_Path::Segment& segment)
+{
+	if (obj)
 	{
-		moveConcatString(result, "\n");
-		for (int i = 0; i < depth; i++)
-			moveConcatString(result, INDENT);
+		ObjectEntry* entry = findEntry(*obj, segment.key, segment.keyLength, segment.hash);
+		return entry ? &entry->prop.val : nullptr;
 	}
 
-	moveConcatString(result, "}");
+	if (array && segment.index < array->size) return &array->items[segment.index];
 
-	return result;
+	return nullptr;
 }
 
-char * arrayToString(pj_Array * array, int depth, pj_boolean isPretty)
+bool compileExtractor(pj_Extractor& extractor, const pj_Field* fields, size_t count)
 {
-	char* result = new char[3]();
+	extractor.fields.assign(fields, fields + count);
+	extractor.paths.resize(count);
+	extractor.nodes.emplace_back();
+	extractor.nodes[0].segment = nullptr;
 
-	result[0] = '[';
-	if (isPretty) result[1] = '\n';
-
-	for (size_t i = 0; i < array->size; i++)
+	for (size_t i = 0; i < count; i++)
 	{
-		if (isPretty)
-		{
-			for (int i = 0; i < depth + 1; i++)
-				moveConcatString(result, INDENT);
-		}
+		pj_Path& path = extractor.paths[i];
+		if (!compilePath(path, fields[i].path)) return false;
 
-		moveConcatString(result, valueToString(array->items[i], depth, isPretty));
+		uint32_t node = 0;
+		for (const pj_Path::Segment& segment : path.segments)
+		{
+			uint32_t next = 0;
+			for (const uint32_t child : extractor.nodes[node].children)
+			{
+				const pj_Path::Segment& other = *extractor.nodes[child].segment;
+				if (other.keyLength == segment.keyLength && memcmp(other.key, segment.key, segment.keyLength) == 0)
+				{
+					next = child;
+					break;
+				}
+			}
 
-		const bool isLast = i == array->size - 1;
+			if (!next)
+			{
+				next = (uint32_t)extractor.nodes.size();
+				extractor.nodes.emplace_back();
+				extractor.nodes[next].segment = &segment;
+				extractor.nodes[node].children.push_back(next);
+			}
 
-		if (!isLast)
-		{
-			moveConcatString(result, ",");
-			if (isPretty) moveConcatString(result, "\n");
+			node = next;
 		}
-	}
 
-	if (isPretty)
-	{
-		moveConcatString(result, "\n");
-		for (int i = 0; i < depth; i++)
-			moveConcatString(result, INDENT);
+		extractor.nodes[node].fields.push_back((uint32_t)i);
 	}
 
-	moveConcatString(result, "]");
-
-	return result;
+	return true;
 }
 
-char * valueToString(JsonVal & val, int depth, pj_boolean isPretty)
+// val is null below a missing member, which still clears the fields down there
+size_t extractNode(const pj_Extractor& extractor, const pj_Extractor::Node& node, JsonVal* val, char* out)
 {
-	char* result = new char();
+	size_t found = 0;
 
-	switch (val.type)
-	{
-	case PJ_VALUE_NUMBER:
-		char numBuffer[255];
-		snprintf(numBuffer, 255, "%f", val.num);
-		moveConcatString(result, numBuffer);
-		break;
-	case PJ_VALUE_STRING:
-		moveConcatStringLiteral(result, val.string);
-		break;
-	case PJ_VALUE_BOOL:
-		if (val.boolean)
-			moveConcatString(result, "true");
-		else
-			moveConcatString(result, "false");
-		break;
-	case PJ_VALUE_OBJ:
-		moveConcatString(result, objectToString(val.obj, depth + 1, isPretty));
-		break;
-	case PJ_VALUE_ARRAY:
-		moveConcatString(result, arrayToString(val.array, depth + 1, isPretty));
-		break;
-	case PJ_VALUE_NULL:
-		moveConcatString(result, "null");
-		break;
-	}
+	for (const uint32_t field : node.fields)
+		found += storeField(extractor.fields[field], val, out);
 
-	return result;
-}
+	if (val && !node.children.empty()) materializeValue(*val);
 
-pj_boolean writeToFile(const char* fileName, char * str)
-{
-	FILE* file = fopen(fileName, "w");
-	if (file == NULL)
+	pj_Object* obj = val && val->type == PJ_VALUE_OBJ ? val->obj : nullptr;
+	pj_Array* array = val && val->type == PJ_VALUE_ARRAY ? val->array : nullptr;
+
+	for (const uint32_t child : node.children)
 	{
-		{
-			std::string error = "Cannot open file: ";
-			error += fileName;
-			errors.push(error);
-		}
-		fclose(file);
-		return false;
+		const pj_Extractor::Node& childNode = extractor.nodes[child];
+		found += extractNode(extractor, childNode, findSegmentValue(obj, array, *childNode.segment), out);
 	}
 
-	fprintf(file, "%s", str);
-	fclose(file);
-	return true;
+	return found;
 }
 
-void addArrayValue(pj_Array & array, JsonVal && val)
+bool storeField(const pj_Field& field, JsonVal* val, char* out)
 {
-	const size_t newSize = array.size + 1;
-	if (newSize + 1 > array.capacity)
-	{
-		JsonVal* newItems = new JsonVal[newSize]();
-
-		for (size_t i = 0; i < array.size; i++)
-		{
-			newItems[i] = std::move(array.items[i]);
-		}
+	void* slot = out + field.offset;
 
-		delete[] array.items;
-		array.items = newItems;
+	switch (field.type)
+	{
+	case PJ_VALUE_NUMBER: return storeValue<double, PJ_VALUE_NUMBER>(slot, val);
+	case PJ_VALUE_INT64: return storeValue<int64_t, PJ_VALUE_INT64>(slot, val);
+	case PJ_VALUE_BOOL: return storeValue<pj_boolean, PJ_VALUE_BOOL>(slot, val);
+	case PJ_VALUE_STRING: return storeValue<const char*, PJ_VALUE_STRING>(slot, val);
+	case PJ_VALUE_OBJ: return storeValue<pj_Object*, PJ_VALUE_OBJ>(slot, val);
+	case PJ_VALUE_ARRAY: return storeValue<pj_Array*, PJ_VALUE_ARRAY>(slot, val);
+	case PJ_VALUE_NULL:
+		*(pj_boolean*)slot = val && val->type == PJ_VALUE_NULL;
+		return val && val->type == PJ_VALUE_NULL;
 	}
 
-	array.items[newSize - 1] = std::move(val);
-	array.size = newSize;
-	array.capacity = newSize;
-}
-
-JsonProp* findProp(pj_Object& obj, const char* propName)
-{
-	auto itr = obj.data.find(propName);
-	if (itr == obj.data.end()) return nullptr;
-
-	return &itr->second;
+	return false;
 }
 
 static void freeHandle(pj_Array* arr) { pj_deleteArray(arr); }